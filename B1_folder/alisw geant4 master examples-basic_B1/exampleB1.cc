@@ -34,22 +34,138 @@
 #include "G4SteppingVerbose.hh"
 #include "G4UImanager.hh"
 #include "QBBC.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4DecayPhysics.hh"
+#include "G4VPhysicsConstructor.hh"
+#include "G4PhysicsListHelper.hh"
+#include "G4MuonMinusCapture.hh"
+#include "G4MuonMinus.hh"
 
 #include "G4VisExecutive.hh"
 #include "G4UIExecutive.hh"
 
+#include "G4Threading.hh"
 #include "Randomize.hh"
 
+#include <cstdlib>
+
 using namespace B1;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+namespace {
+  void PrintUsage() {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " exampleB1 [-m macro ] [-t nThreads] [-r Serial|MT|Tasking] [-p QBBC|EM0|EM4]" << G4endl;
+    G4cerr << "   or exampleB1 macro" << G4endl;
+    G4cerr << "   the number of threads can also be set with B1_NUM_THREADS," << G4endl;
+    G4cerr << "   by default all of the cores are used" << G4endl;
+    G4cerr << "   EM0 and EM4 are lean physics lists, standard or option 4" << G4endl;
+    G4cerr << "   electromagnetic physics with decays and mu- capture at rest," << G4endl;
+    G4cerr << "   for the muon runs" << G4endl;
+  }
+
+  // Reads a number of threads, a whole number with nothing after it, 0 for
+  // all of the cores. Returns false for anything else, rather than letting
+  // atoi turn it into 0.
+  G4bool ParseThreads(const char* text, G4int& nThreads) {
+    char* end = nullptr;
+    long value = std::strtol(text, &end, 10);
+    if ( end == text || *end != '\0' || value < 0 || value > 1024 ) return false;
+    nThreads = G4int(value);
+    return true;
+  }
+
+  // Capture of stopped mu- by the nucleus. A 2 MeV mu- stops within
+  // millimetres, and without this it would always decay at its free
+  // lifetime, unlike in QBBC. Only the capture is registered, not the rest of
+  // G4StoppingPhysics with its hadron absorption models.
+  class MuonCapturePhysics : public G4VPhysicsConstructor {
+    public:
+      MuonCapturePhysics() : G4VPhysicsConstructor("muonMinusCapture") {}
+      virtual void ConstructParticle() { G4MuonMinus::MuonMinus(); }
+      virtual void ConstructProcess() {
+        G4PhysicsListHelper::GetPhysicsListHelper()
+          ->RegisterProcess(new G4MuonMinusCapture(), G4MuonMinus::MuonMinus());
+      }
+  };
+
+  // Electromagnetic physics, decays and mu- capture at rest, enough for the
+  // muons fired by B1PrimaryGeneratorAction without loading the hadronic
+  // physics of QBBC.
+  G4VModularPhysicsList* LeanPhysicsList(G4bool option4) {
+    G4VModularPhysicsList* physicsList = new G4VModularPhysicsList();
+    if ( option4 ) physicsList->RegisterPhysics(new G4EmStandardPhysics_option4());
+    else           physicsList->RegisterPhysics(new G4EmStandardPhysics());
+    physicsList->RegisterPhysics(new G4DecayPhysics());
+    physicsList->RegisterPhysics(new MuonCapturePhysics());
+    return physicsList;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 int main(int argc,char** argv)
 {
-  // Detect interactive mode (if no arguments) and define UI session
+  // Evaluate arguments
+  //
+  if ( argc > 9 ) {
+    PrintUsage();
+    return 1;
+  }
+
+  G4String macro;
+  G4String runManagerName = "Tasking";
+  G4String physicsName = "QBBC";
+  G4int nThreads = 0;
+  if ( const char* env = std::getenv("B1_NUM_THREADS") ) {
+    if ( ! ParseThreads(env, nThreads) ) {
+      G4cerr << " B1_NUM_THREADS is not a number of threads: " << env << G4endl;
+      PrintUsage();
+      return 1;
+    }
+  }
+  if ( argc == 2 ) {
+    macro = argv[1];
+  }
+  else {
+    for ( G4int i=1; i<argc; i=i+2 ) {
+      if ( i+1 >= argc ) {
+        PrintUsage();
+        return 1;
+      }
+      if      ( G4String(argv[i]) == "-m" ) macro = argv[i+1];
+      else if ( G4String(argv[i]) == "-t" ) {
+        if ( ! ParseThreads(argv[i+1], nThreads) ) {
+          PrintUsage();
+          return 1;
+        }
+      }
+      else if ( G4String(argv[i]) == "-r" ) runManagerName = argv[i+1];
+      else if ( G4String(argv[i]) == "-p" ) physicsName = argv[i+1];
+      else {
+        PrintUsage();
+        return 1;
+      }
+    }
+  }
+  if ( nThreads <= 0 ) nThreads = G4Threading::G4GetNumberOfCores();
+  if ( physicsName != "QBBC" && physicsName != "EM0" && physicsName != "EM4" ) {
+    PrintUsage();
+    return 1;
+  }
+  if ( runManagerName != "Serial" && runManagerName != "MT"
+       && runManagerName != "Tasking" ) {
+    PrintUsage();
+    return 1;
+  }
+
+  // Detect interactive mode (if no macro) and define UI session
   //
   G4UIExecutive* ui = nullptr;
-  if ( argc == 1 ) { ui = new G4UIExecutive(argc, argv); }
+  if ( ! macro.size() ) { ui = new G4UIExecutive(argc, argv); }
 
   // Optionally: choose a different Random engine...
   // G4Random::setTheEngine(new CLHEP::MTwistEngine);
@@ -58,10 +174,18 @@ int main(int argc,char** argv)
   G4int precision = 4;
   G4SteppingVerbose::UseBestUnit(precision);
 
-  // Construct the default run manager
+  // Construct the run manager, multi-threaded with tasks unless asked
+  // otherwise, with one worker per core by default. The workers each have
+  // their own user actions and scoring, which the master merges at the end
+  // of the run.
   //
+  G4RunManagerType runManagerType = G4RunManagerType::Tasking;
+  if      ( runManagerName == "Serial" ) runManagerType = G4RunManagerType::Serial;
+  else if ( runManagerName == "MT" )     runManagerType = G4RunManagerType::MT;
+
   auto* runManager =
-    G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
+    G4RunManagerFactory::CreateRunManager(runManagerType);
+  runManager->SetNumberOfThreads(nThreads);
 
   // Set mandatory initialization classes
   //
@@ -69,7 +193,10 @@ int main(int argc,char** argv)
   runManager->SetUserInitialization(new DetectorConstruction());
 
   // Physics list
-  G4VModularPhysicsList* physicsList = new QBBC;
+  G4VModularPhysicsList* physicsList = nullptr;
+  if      ( physicsName == "EM0" ) physicsList = LeanPhysicsList(false);
+  else if ( physicsName == "EM4" ) physicsList = LeanPhysicsList(true);
+  else                             physicsList = new QBBC;
   physicsList->SetVerboseLevel(1);
   runManager->SetUserInitialization(physicsList);
 
@@ -91,8 +218,7 @@ int main(int argc,char** argv)
   if ( ! ui ) {
     // batch mode
     G4String command = "/control/execute ";
-    G4String fileName = argv[1];
-    UImanager->ApplyCommand(command+fileName);
+    UImanager->ApplyCommand(command+macro);
   }
   else {
     // interactive mode
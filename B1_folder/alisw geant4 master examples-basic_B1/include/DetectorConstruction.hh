@@ -32,6 +32,7 @@
 
 #include "G4VUserDetectorConstruction.hh"
 #include "globals.hh"
+#include "G4ThreeVector.hh"
 
 #include <vector>
 
@@ -48,12 +49,26 @@ class B1DetectorConstruction : public G4VUserDetectorConstruction
     virtual ~B1DetectorConstruction();
 
     virtual G4VPhysicalVolume* Construct();
+    virtual void ConstructSDandField();
     
     //changed fscoringvolume into a vector rather than a single value
-    std::vector<G4LogicalVolume*> GetScoringVolume() const { return fScoringVolume; }
+    const std::vector<G4LogicalVolume*>& GetScoringVolume() const { return fScoringVolume; }
+
+    // number of pixels (envelopes), their copy numbers run from 0 to this - 1
+    G4int GetNumberOfPixels() const { return fNumberOfPixels; }
+
+    // the corners of the box around the pixel lattice
+    const G4ThreeVector& GetLatticeLower() const { return fLatticeLower; }
+    const G4ThreeVector& GetLatticeUpper() const { return fLatticeUpper; }
 
   protected:
+    // the Silicon and Passive regions, set up for a built or a cached geometry
+    void DefineRegions(G4LogicalVolume* logicEnv);
+
     std::vector<G4LogicalVolume*>  fScoringVolume;
+    G4int                          fNumberOfPixels;
+    G4ThreeVector                  fLatticeLower;
+    G4ThreeVector                  fLatticeUpper;
 };
 
 
@@ -0,0 +1,88 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DiodeAccumulable.hh
+/// \brief Definition of the B1DiodeAccumulable class
+
+#ifndef B1DiodeAccumulable_h
+#define B1DiodeAccumulable_h 1
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+
+#include <vector>
+
+/// Per diode accumulable
+///
+/// It holds, for each diode (indexed by the copy number of its envelope),
+/// the energy deposited in the run, its square summed over events, the
+/// number of events with a deposit and a histogram of the deposit per event.
+/// Each thread fills its own copy, and Merge() adds a worker's arrays into
+/// the master's element by element, once per worker at the end of the run,
+/// so there is no locking per diode.
+
+class B1DiodeAccumulable : public G4VAccumulable
+{
+  public:
+    B1DiodeAccumulable(const G4String& name,
+                       G4int nofBins, G4double histMax);
+    virtual ~B1DiodeAccumulable();
+
+    // methods from the base class
+    virtual void Merge(const G4VAccumulable& other);
+    virtual void Reset();
+
+    // sizes the arrays for the given number of diodes, keeping what is in them
+    void SetNumberOfDiodes(G4int nofDiodes);
+
+    // changes the histogram binning, emptying the histogram if it changes
+    void SetHistogram(G4int nofBins, G4double histMax);
+
+    // adds the energy deposited in a diode in one event
+    void Fill(G4int diode, G4double edep);
+
+    G4int    GetNumberOfDiodes() const  { return G4int(fEdep.size()); }
+    G4int    GetNumberOfBins() const    { return fNofBins; }
+    G4double GetHistMax() const         { return fHistMax; }
+    G4double GetEdep(G4int diode) const  { return fEdep[diode]; }
+    G4double GetEdep2(G4int diode) const { return fEdep2[diode]; }
+    G4int    GetEvents(G4int diode) const { return fEvents[diode]; }
+    // the last bin also counts the deposits above the histogram
+    G4int    GetBin(G4int diode, G4int bin) const
+      { return fHist[std::size_t(diode) * fNofBins + bin]; }
+
+  private:
+    G4int                 fNofBins;
+    G4double              fHistMax;
+    std::vector<G4double> fEdep;
+    std::vector<G4double> fEdep2;
+    std::vector<G4int>    fEvents;
+    std::vector<G4int>    fHist;     // fNofBins bins for each diode, in one block
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,106 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DiodeHit.hh
+/// \brief Definition of the B1DiodeHit class
+
+#ifndef B1DiodeHit_h
+#define B1DiodeHit_h 1
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "G4ThreeVector.hh"
+#include "tls.hh"
+
+/// Diode hit class
+///
+/// It records the energy deposit of one step in the diode silicon, with
+/// the copy number of the envelope (the pixel) it is in, the position and
+/// the global time of the step. Hits come from a thread local G4Allocator,
+/// so making one does not go to the heap.
+
+class B1DiodeHit : public G4VHit
+{
+  public:
+    B1DiodeHit();
+    B1DiodeHit(const B1DiodeHit&);
+    virtual ~B1DiodeHit();
+
+    // operators
+    const B1DiodeHit& operator=(const B1DiodeHit&);
+    G4bool operator==(const B1DiodeHit&) const;
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void*);
+
+    // methods from base class
+    virtual void Print();
+
+    // Set methods
+    void SetPixelNo (G4int pixel)       { fPixelNo = pixel; };
+    void SetEdep    (G4double de)       { fEdep = de; };
+    void SetPos     (G4ThreeVector xyz) { fPos = xyz; };
+    void SetTime    (G4double time)     { fTime = time; };
+
+    // Get methods
+    G4int GetPixelNo() const     { return fPixelNo; };
+    G4double GetEdep() const     { return fEdep; };
+    G4ThreeVector GetPos() const { return fPos; };
+    G4double GetTime() const     { return fTime; };
+
+  private:
+    G4int         fPixelNo;
+    G4double      fEdep;
+    G4ThreeVector fPos;
+    G4double      fTime;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+typedef G4THitsCollection<B1DiodeHit> B1DiodeHitsCollection;
+
+extern G4ThreadLocal G4Allocator<B1DiodeHit>* B1DiodeHitAllocator;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void* B1DiodeHit::operator new(size_t)
+{
+  if(!B1DiodeHitAllocator)
+      B1DiodeHitAllocator = new G4Allocator<B1DiodeHit>;
+  return (void *) B1DiodeHitAllocator->MallocSingle();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void B1DiodeHit::operator delete(void *hit)
+{
+  B1DiodeHitAllocator->FreeSingle((B1DiodeHit*) hit);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -33,6 +33,8 @@
 #include "G4UserEventAction.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class B1RunAction;
 
 /// Event action class
@@ -48,10 +50,17 @@ class B1EventAction : public G4UserEventAction
     virtual void EndOfEventAction(const G4Event* event);
 
     void AddEdep(G4double edep) { fEdep += edep; }
+    void AddDiodeEdep(G4int pixel, G4double edep)
+    {
+      if (fDiodeEdep[pixel] == 0.) fHitPixels.push_back(pixel);
+      fDiodeEdep[pixel] += edep;
+    }
 
   private:
     B1RunAction* fRunAction;
     G4double     fEdep;
+    std::vector<G4double> fDiodeEdep;   // deposit in each diode in this event
+    std::vector<G4int>    fHitPixels;   // the diodes with a deposit in this event
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
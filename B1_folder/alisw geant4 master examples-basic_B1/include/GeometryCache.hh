@@ -0,0 +1,70 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file GeometryCache.hh
+/// \brief Definition of the B1GeometryCache class
+
+#ifndef B1GeometryCache_h
+#define B1GeometryCache_h 1
+
+#include "globals.hh"
+
+class G4VPhysicalVolume;
+
+/// GDML cache of the built geometry.
+///
+/// The cache file is named after a hash of the layout string, which holds the
+/// parameters of the layout and the versions of its components and lattice,
+/// so every layout has its own file. The first run
+/// of a layout builds the geometry, with the overlap checks, and writes it; the
+/// later runs read it back instead. The cache goes in the working directory,
+/// or in the directory given by the B1_GEOMETRY_CACHE environment variable;
+/// B1_GEOMETRY_CACHE=off switches it off.
+///
+/// Without GDML support in Geant4 (G4LIB_USE_GDML) the cache is always off.
+
+class B1GeometryCache
+{
+  public:
+    B1GeometryCache(const G4String& layout);
+    ~B1GeometryCache();
+
+    // the cached world, or 0 if the layout has not been cached yet
+    G4VPhysicalVolume* Read() const;
+    // write the world to the cache, done once the geometry is built
+    void Write(G4VPhysicalVolume* world) const;
+
+    G4bool IsEnabled() const { return fEnabled; }
+    const G4String& GetFileName() const { return fFileName; }
+
+  private:
+    G4bool    fEnabled;
+    G4String  fFileName;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,74 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PixelParameterisation.hh
+/// \brief Definition of the B1PixelParameterisation class
+
+#ifndef B1PixelParameterisation_h
+#define B1PixelParameterisation_h 1
+
+#include "G4VPVParameterisation.hh"
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+class G4VPhysicalVolume;
+
+/// Parameterisation of the lattice of pixel envelopes.
+///
+/// The copy number of an envelope is its pixel index, k + len * j + len * len * i
+/// with k, j and i counting along x, y and z. Every other z layer is offset by
+/// half an envelope in x and y. The position is worked out from the copy number
+/// when the navigator needs it, so the lattice costs the same memory whatever
+/// its size.
+
+class B1PixelParameterisation : public G4VPVParameterisation
+{
+  public:
+    // version of the lattice positions, part of the geometry cache key:
+    // bump it with any change to ComputeTransformation
+    static const G4int kVersion = 1;
+
+    B1PixelParameterisation(G4int len,
+                            G4double env_sizeX, G4double env_sizeY, G4double env_sizeZ);
+    virtual ~B1PixelParameterisation();
+
+    // method from the base class
+    virtual void ComputeTransformation(const G4int copyNo,
+                                       G4VPhysicalVolume* physVol) const;
+
+    // the corners of the box around all of the envelopes
+    void GetExtent(G4ThreeVector& lower, G4ThreeVector& upper) const;
+
+  private:
+    G4int     fLen;
+    G4double  fEnvSizeX;
+    G4double  fEnvSizeY;
+    G4double  fEnvSizeZ;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -32,15 +32,22 @@
 
 #include "G4UserRunAction.hh"
 #include "G4Accumulable.hh"
+#include "DiodeAccumulable.hh"
+#include "G4Timer.hh"
 #include "globals.hh"
 
 class G4Run;
+class G4GenericMessenger;
 
 /// Run action class
 ///
 /// In EndOfRunAction(), it calculates the dose in the selected volume 
 /// from the energy deposit accumulated via stepping and event actions.
 /// The computed dose is then printed on the screen.
+/// The deposit in each diode, and a histogram of it per event, is written
+/// to diodes.csv by the master. The histogram binning is set with the
+/// /B1/diodes/ commands, by default 100 bins up to 50 keV, which suits the
+/// few keV to tens of keV deposited in the 4 um diode silicon.
 
 class B1RunAction : public G4UserRunAction
 {
@@ -53,10 +60,23 @@ class B1RunAction : public G4UserRunAction
     virtual void   EndOfRunAction(const G4Run*);
 
     void AddEdep (G4double edep); 
+    void AddDiodeEdep (G4int pixel, G4double edep) { fDiodes.Fill(pixel, edep); }
+    void CountKilledBelowThreshold() { fKilledBelowThreshold += 1; }
+    void CountKilledOutsideLattice() { fKilledOutsideLattice += 1; }
 
   private:
+    void WriteDiodes(G4int nofEvents) const;
+    void DefineCommands();
+
     G4Accumulable<G4double> fEdep;
     G4Accumulable<G4double> fEdep2;
+    B1DiodeAccumulable      fDiodes;
+    G4Accumulable<G4int>    fKilledBelowThreshold;   // secondaries killed by B1StackingAction,
+    G4Accumulable<G4int>    fKilledOutsideLattice;   // for each reason
+    G4Timer                 fTimer;
+    G4GenericMessenger*     fMessenger;
+    G4int                   fNofBins;                // binning of the diode histograms,
+    G4double                fHistMax;                // applied at the start of each run
 };
 
 #endif
@@ -0,0 +1,76 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StackingAction.hh
+/// \brief Definition of the B1StackingAction class
+
+#ifndef B1StackingAction_h
+#define B1StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class B1RunAction;
+class G4GenericMessenger;
+
+/// Stacking action class
+///
+/// Secondaries unlikely to reach a diode are killed as they are made:
+/// those below an energy threshold, and those outside the box around the
+/// pixel lattice that are moving away from it. The geometric kill is an
+/// approximation: there is no field, but photons can Compton scatter and
+/// electrons multiple scatter in the world air and turn back, so some killed
+/// secondaries could have reached a diode. The kills are counted per reason
+/// in the run action, to be read as a possible bias on the dose. The
+/// threshold and the geometric check are set with /B1/stack/ commands.
+
+class B1StackingAction : public G4UserStackingAction
+{
+  public:
+    B1StackingAction(B1RunAction* runAction);
+    virtual ~B1StackingAction();
+
+    // method from the base class
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track*);
+
+  private:
+    G4bool MovingAway(const G4ThreeVector& position,
+                      const G4ThreeVector& direction) const;
+    void DefineCommands();
+
+    B1RunAction*        fRunAction;
+    G4GenericMessenger* fMessenger;
+    G4double            fEnergyThreshold;
+    G4bool              fKillOutside;
+    G4bool              fHaveLattice;
+    G4ThreeVector       fLatticeLower;
+    G4ThreeVector       fLatticeUpper;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
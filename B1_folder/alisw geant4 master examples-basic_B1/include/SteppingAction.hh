@@ -33,7 +33,7 @@
 #include "G4UserSteppingAction.hh"
 #include "globals.hh"
 
-#include <vector>
+#include <unordered_set>
 
 class B1EventAction;
 
@@ -53,7 +53,7 @@ class B1SteppingAction : public G4UserSteppingAction
 
   private:
     B1EventAction*  fEventAction;
-    std::vector<G4LogicalVolume*> fScoringVolume; //made fScoringVolume a vector
+    std::unordered_set<const G4LogicalVolume*> fScoringVolume; //a set, so checking a step is O(1) however many there are
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
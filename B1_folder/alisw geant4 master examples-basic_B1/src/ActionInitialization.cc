@@ -32,6 +32,7 @@
 #include "B1RunAction.hh"
 #include "B1EventAction.hh"
 #include "B1SteppingAction.hh"
+#include "StackingAction.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -65,6 +66,7 @@ void B1ActionInitialization::Build() const
   SetUserAction(eventAction);
   
   SetUserAction(new B1SteppingAction(eventAction));
+  SetUserAction(new B1StackingAction(runAction));
 }  
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
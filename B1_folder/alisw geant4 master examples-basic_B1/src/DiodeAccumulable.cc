@@ -0,0 +1,113 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DiodeAccumulable.cc
+/// \brief Implementation of the B1DiodeAccumulable class
+
+#include "DiodeAccumulable.hh"
+
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeAccumulable::B1DiodeAccumulable(const G4String& name,
+                                       G4int nofBins, G4double histMax)
+: G4VAccumulable(name),
+  fNofBins(nofBins),
+  fHistMax(histMax)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeAccumulable::~B1DiodeAccumulable()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeAccumulable::SetNumberOfDiodes(G4int nofDiodes)
+{
+  if (nofDiodes <= GetNumberOfDiodes()) return;
+
+  fEdep.resize(nofDiodes, 0.);
+  fEdep2.resize(nofDiodes, 0.);
+  fEvents.resize(nofDiodes, 0);
+  fHist.resize(std::size_t(nofDiodes) * fNofBins, 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeAccumulable::SetHistogram(G4int nofBins, G4double histMax)
+{
+  if (nofBins == fNofBins && histMax == fHistMax) return;
+
+  fNofBins = nofBins;
+  fHistMax = histMax;
+  fHist.assign(fEdep.size() * fNofBins, 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeAccumulable::Fill(G4int diode, G4double edep)
+{
+  fEdep[diode]  += edep;
+  fEdep2[diode] += edep*edep;
+  ++fEvents[diode];
+
+  G4int bin = G4int(edep / fHistMax * fNofBins);
+  bin = std::min(std::max(bin, 0), fNofBins - 1);
+  ++fHist[std::size_t(diode) * fNofBins + bin];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeAccumulable::Merge(const G4VAccumulable& other)
+{
+  const B1DiodeAccumulable& otherDiodes
+    = static_cast<const B1DiodeAccumulable&>(other);
+
+  SetNumberOfDiodes(otherDiodes.GetNumberOfDiodes());
+
+  for (std::size_t i = 0; i < otherDiodes.fEdep.size(); ++i) {
+    fEdep[i]   += otherDiodes.fEdep[i];
+    fEdep2[i]  += otherDiodes.fEdep2[i];
+    fEvents[i] += otherDiodes.fEvents[i];
+  }
+  for (std::size_t i = 0; i < otherDiodes.fHist.size(); ++i) {
+    fHist[i] += otherDiodes.fHist[i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeAccumulable::Reset()
+{
+  std::fill(fEdep.begin(), fEdep.end(), 0.);
+  std::fill(fEdep2.begin(), fEdep2.end(), 0.);
+  std::fill(fEvents.begin(), fEvents.end(), 0);
+  std::fill(fHist.begin(), fHist.end(), 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
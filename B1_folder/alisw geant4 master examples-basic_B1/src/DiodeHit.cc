@@ -0,0 +1,97 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DiodeHit.cc
+/// \brief Implementation of the B1DiodeHit class
+
+#include "DiodeHit.hh"
+
+#include "G4UnitsTable.hh"
+
+#include <iomanip>
+
+G4ThreadLocal G4Allocator<B1DiodeHit>* B1DiodeHitAllocator=0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeHit::B1DiodeHit()
+ : G4VHit(),
+   fPixelNo(-1),
+   fEdep(0.),
+   fPos(G4ThreeVector()),
+   fTime(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeHit::~B1DiodeHit() {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeHit::B1DiodeHit(const B1DiodeHit& right)
+  : G4VHit()
+{
+  fPixelNo   = right.fPixelNo;
+  fEdep      = right.fEdep;
+  fPos       = right.fPos;
+  fTime      = right.fTime;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B1DiodeHit& B1DiodeHit::operator=(const B1DiodeHit& right)
+{
+  fPixelNo   = right.fPixelNo;
+  fEdep      = right.fEdep;
+  fPos       = right.fPos;
+  fTime      = right.fTime;
+
+  return *this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B1DiodeHit::operator==(const B1DiodeHit& right) const
+{
+  return ( this == &right ) ? true : false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeHit::Print()
+{
+  G4cout
+     << "  pixel: " << std::setw(5) << fPixelNo
+     << " Edep: "
+     << std::setw(7) << G4BestUnit(fEdep,"Energy")
+     << " Position: "
+     << std::setw(7) << G4BestUnit( fPos,"Length")
+     << " Time: "
+     << std::setw(7) << G4BestUnit(fTime,"Time")
+     << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,112 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DiodeSD.cc
+/// \brief Implementation of the B1DiodeSD class
+
+#include "DiodeSD.hh"
+
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+#include "G4ThreeVector.hh"
+#include "G4SDManager.hh"
+#include "G4ios.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeSD::B1DiodeSD(const G4String& name,
+                     const G4String& hitsCollectionName)
+ : G4VSensitiveDetector(name),
+   fHitsCollection(0),
+   fHCID(-1)
+{
+  collectionName.insert(hitsCollectionName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1DiodeSD::~B1DiodeSD()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeSD::Initialize(G4HCofThisEvent* hce)
+{
+  // Create hits collection
+
+  fHitsCollection
+    = new B1DiodeHitsCollection(SensitiveDetectorName, collectionName[0]);
+
+  // Add this collection in hce, the id is looked up on the first event only
+
+  if (fHCID < 0) {
+    fHCID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+  }
+  hce->AddHitsCollection( fHCID, fHitsCollection );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B1DiodeSD::ProcessHits(G4Step* step,
+                              G4TouchableHistory*)
+{
+  // energy deposit
+  G4double edep = step->GetTotalEnergyDeposit();
+
+  if (edep==0.) return false;
+
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+
+  // the diode silicon sits in the diode, which sits in the envelope,
+  // so the envelope (the pixel) is two levels up
+  G4int pixelNo = preStepPoint->GetTouchableHandle()->GetCopyNumber(2);
+
+  B1DiodeHit* newHit = new B1DiodeHit();
+
+  newHit->SetPixelNo(pixelNo);
+  newHit->SetEdep(edep);
+  newHit->SetPos (preStepPoint->GetPosition());
+  newHit->SetTime(preStepPoint->GetGlobalTime());
+
+  fHitsCollection->insert( newHit );
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DiodeSD::EndOfEvent(G4HCofThisEvent*)
+{
+  if ( verboseLevel>1 ) {
+     G4int nofHits = fHitsCollection->entries();
+     G4cout << G4endl
+            << "-------->Hits Collection: in this event they are " << nofHits
+            << " hits in the diodes: " << G4endl;
+     for ( G4int i=0; i<nofHits; i++ ) (*fHitsCollection)[i]->Print();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
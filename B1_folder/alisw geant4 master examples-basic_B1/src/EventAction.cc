@@ -29,6 +29,7 @@
 
 #include "B1EventAction.hh"
 #include "B1RunAction.hh"
+#include "B1DetectorConstruction.hh"
 
 #include "G4Event.hh"
 #include "G4RunManager.hh"
@@ -51,6 +52,13 @@ B1EventAction::~B1EventAction()
 void B1EventAction::BeginOfEventAction(const G4Event*)
 {    
   fEdep = 0.;
+
+  if (fDiodeEdep.empty()) {
+    const B1DetectorConstruction* detectorConstruction
+      = static_cast<const B1DetectorConstruction*>
+        (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    fDiodeEdep.assign(detectorConstruction->GetNumberOfPixels(), 0.);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -59,6 +67,13 @@ void B1EventAction::EndOfEventAction(const G4Event*)
 {   
   // accumulate statistics in run action
   fRunAction->AddEdep(fEdep);
+
+  // only the diodes hit in this event are passed on and cleared
+  for (G4int pixel: fHitPixels) {
+    fRunAction->AddDiodeEdep(pixel, fDiodeEdep[pixel]);
+    fDiodeEdep[pixel] = 0.;
+  }
+  fHitPixels.clear();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,127 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file GeometryCache.cc
+/// \brief Implementation of the B1GeometryCache class
+
+#include "GeometryCache.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4ios.hh"
+
+#ifdef G4LIB_USE_GDML
+#include "G4GDMLParser.hh"
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1GeometryCache::B1GeometryCache(const G4String& layout)
+: fEnabled(false),
+  fFileName()
+{
+#ifdef G4LIB_USE_GDML
+  G4String dir = ".";
+  if ( const char* env = std::getenv("B1_GEOMETRY_CACHE") ) {
+    dir = env;
+  }
+  if ( dir == "off" ) return;
+
+  // 64-bit FNV-1a hash of the layout, it is the same for every build and
+  // platform, unlike std::hash
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (char c: layout) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  std::ostringstream name;
+  name << dir << "/B1geometry_" << std::hex << std::setw(16)
+       << std::setfill('0') << hash << ".gdml";
+  fFileName = name.str();
+  fEnabled = true;
+#else
+  (void)layout;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1GeometryCache::~B1GeometryCache()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VPhysicalVolume* B1GeometryCache::Read() const
+{
+#ifdef G4LIB_USE_GDML
+  if ( !fEnabled || !std::ifstream(fFileName).good() ) return 0;
+
+  G4cout << "Reading the geometry from the cache " << fFileName << G4endl;
+
+  // the file was written by this program, so the schema validation is skipped
+  G4GDMLParser parser;
+  parser.Read(fFileName, false);
+  return parser.GetWorldVolume();
+#else
+  return 0;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1GeometryCache::Write(G4VPhysicalVolume* world) const
+{
+#ifdef G4LIB_USE_GDML
+  if ( !fEnabled ) return;
+
+  G4cout << "Writing the geometry to the cache " << fFileName << G4endl;
+
+  // write to a file of this job and rename it, so jobs started together never
+  // read a half written cache; GDML refuses to write over an existing file
+  std::ostringstream tmpName;
+  tmpName << fFileName << "." << std::hex << std::random_device()() << ".tmp";
+  std::remove(tmpName.str().c_str());
+
+  G4GDMLParser parser;
+  parser.Write(tmpName.str(), world);
+  if ( std::rename(tmpName.str().c_str(), fFileName.c_str()) != 0 ) {
+    G4cerr << "Could not write the geometry cache " << fFileName << G4endl;
+    std::remove(tmpName.str().c_str());
+  }
+#else
+  (void)world;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,86 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PixelParameterisation.cc
+/// \brief Implementation of the B1PixelParameterisation class
+
+#include "PixelParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1PixelParameterisation::B1PixelParameterisation(G4int len,
+                                                 G4double env_sizeX, G4double env_sizeY, G4double env_sizeZ)
+: G4VPVParameterisation(),
+  fLen(len),
+  fEnvSizeX(env_sizeX),
+  fEnvSizeY(env_sizeY),
+  fEnvSizeZ(env_sizeZ)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1PixelParameterisation::~B1PixelParameterisation()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1PixelParameterisation::ComputeTransformation(const G4int copyNo,
+                                                    G4VPhysicalVolume* physVol) const
+{
+  G4int k = copyNo % fLen;
+  G4int j = (copyNo / fLen) % fLen;
+  G4int i = copyNo / (fLen * fLen);
+
+  // every other z layer is offset by half an envelope
+  G4double offset = (i % 2 == 1) ? 0.5 : 0.;
+
+  G4ThreeVector position(((fLen / 2) - (k + offset)) * fEnvSizeX,
+                         ((fLen / 2) - (j + offset)) * fEnvSizeY,
+                         ((fLen / 2) - i) * fEnvSizeZ);
+
+  physVol->SetTranslation(position);
+  physVol->SetRotation(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1PixelParameterisation::GetExtent(G4ThreeVector& lower,
+                                        G4ThreeVector& upper) const
+{
+  // the offset layers reach half an envelope further down in x and y
+  G4double offset = (fLen > 1) ? 0.5 : 0.;
+
+  upper = G4ThreeVector(((fLen / 2) + 0.5) * fEnvSizeX,
+                        ((fLen / 2) + 0.5) * fEnvSizeY,
+                        ((fLen / 2) + 0.5) * fEnvSizeZ);
+  lower = G4ThreeVector(((fLen / 2) - (fLen - 1) - offset - 0.5) * fEnvSizeX,
+                        ((fLen / 2) - (fLen - 1) - offset - 0.5) * fEnvSizeY,
+                        ((fLen / 2) - (fLen - 1) - 0.5) * fEnvSizeZ);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
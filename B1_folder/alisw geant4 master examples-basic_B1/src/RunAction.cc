@@ -28,6 +28,8 @@
 /// \brief Implementation of the B1RunAction class
 
 #include <vector>
+#include <fstream>
+#include <algorithm>
 
 #include "B1RunAction.hh"
 #include "B1PrimaryGeneratorAction.hh"
@@ -40,6 +42,7 @@
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
 #include "G4UnitsTable.hh"
+#include "G4GenericMessenger.hh"
 #include "G4SystemOfUnits.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -47,7 +50,13 @@
 B1RunAction::B1RunAction()
 : G4UserRunAction(),
   fEdep(0.),
-  fEdep2(0.)
+  fEdep2(0.),
+  fDiodes("Diodes", 100, 50.*keV),
+  fKilledBelowThreshold(0),
+  fKilledOutsideLattice(0),
+  fMessenger(0),
+  fNofBins(100),
+  fHistMax(50.*keV)
 { 
   // add new units for dose
   // 
@@ -65,12 +74,19 @@ B1RunAction::B1RunAction()
   G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
   accumulableManager->RegisterAccumulable(fEdep);
   accumulableManager->RegisterAccumulable(fEdep2); 
+  accumulableManager->RegisterAccumulable(&fDiodes);
+  accumulableManager->RegisterAccumulable(fKilledBelowThreshold);
+  accumulableManager->RegisterAccumulable(fKilledOutsideLattice);
+
+  DefineCommands();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B1RunAction::~B1RunAction()
-{}
+{
+  delete fMessenger;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -83,12 +99,23 @@ void B1RunAction::BeginOfRunAction(const G4Run*)
   G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
   accumulableManager->Reset();
 
+  // the binning from the /B1/diodes/ commands, then one entry per diode,
+  // the geometry is built by now
+  fDiodes.SetHistogram(fNofBins, fHistMax);
+  const B1DetectorConstruction* detectorConstruction
+      = static_cast<const B1DetectorConstruction*>
+      (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  fDiodes.SetNumberOfDiodes(detectorConstruction->GetNumberOfPixels());
+
+  fTimer.Start();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void B1RunAction::EndOfRunAction(const G4Run* run)
 {
+    fTimer.Stop();
+
     G4int nofEvents = run->GetNumberOfEvent();
     if (nofEvents == 0) return;
 
@@ -158,8 +185,46 @@ void B1RunAction::EndOfRunAction(const G4Run* run)
      << "------------------------------------------------------------\n"
      //printed the cumulated dose from all the diodes to see the energy deposited
      << " Cumulated energy is " << edep <<" MeV \n"
+     << " Secondaries killed: " << fKilledBelowThreshold.GetValue()
+     << " below the energy threshold, " << fKilledOutsideLattice.GetValue()
+     << " outside the lattice"
+     << G4endl
+     << " Run time " << fTimer.GetRealElapsed() << " s, "
+     << nofEvents / std::max(fTimer.GetRealElapsed(), 1e-9) << " events/s"
      << G4endl
      << G4endl;
+
+  if (IsMaster()) WriteDiodes(nofEvents);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1RunAction::WriteDiodes(G4int nofEvents) const
+{
+  // one line per diode with a deposit: its pixel, the total deposit and its rms
+  // over the events, the number of events with a deposit, then the histogram
+  std::ofstream file("diodes.csv");
+  file << "pixel,edep_MeV,rms_MeV,events";
+  for (G4int bin = 0; bin < fDiodes.GetNumberOfBins(); ++bin) file << ",bin" << bin;
+  file << "\n";
+
+  G4int hitDiodes = 0;
+  for (G4int diode = 0; diode < fDiodes.GetNumberOfDiodes(); ++diode) {
+    if (fDiodes.GetEvents(diode) == 0) continue;
+    ++hitDiodes;
+    G4double edep = fDiodes.GetEdep(diode);
+    G4double rms = fDiodes.GetEdep2(diode) - edep*edep/nofEvents;
+    if (rms > 0.) rms = std::sqrt(rms); else rms = 0.;
+    file << diode << "," << edep/MeV << "," << rms/MeV << "," << fDiodes.GetEvents(diode);
+    for (G4int bin = 0; bin < fDiodes.GetNumberOfBins(); ++bin) file << "," << fDiodes.GetBin(diode, bin);
+    file << "\n";
+  }
+
+  G4cout
+     << " " << hitDiodes << " of " << fDiodes.GetNumberOfDiodes()
+     << " diodes had a deposit, written to diodes.csv (histogram bins of "
+     << G4BestUnit(fDiodes.GetHistMax()/fDiodes.GetNumberOfBins(),"Energy") << ")"
+     << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -171,4 +236,26 @@ void B1RunAction::AddEdep(G4double edep)
 }
 
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1RunAction::DefineCommands()
+{
+  fMessenger
+    = new G4GenericMessenger(this, "/B1/diodes/", "Diode energy deposit histograms");
+
+  auto& binsCmd
+    = fMessenger->DeclareProperty("nofBins", fNofBins,
+                                  "Number of bins of the deposit per event histogram of each diode.");
+  binsCmd.SetParameterName("nofBins", true);
+  binsCmd.SetRange("nofBins>0");
+  binsCmd.SetDefaultValue("100");
+
+  auto& maxCmd
+    = fMessenger->DeclarePropertyWithUnit("histMax", "keV", fHistMax,
+                                          "Upper edge of the histograms, larger deposits go in the last bin.");
+  maxCmd.SetParameterName("histMax", true);
+  maxCmd.SetRange("histMax>0.");
+  maxCmd.SetDefaultValue("50.");
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
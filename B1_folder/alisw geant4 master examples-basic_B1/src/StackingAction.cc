@@ -0,0 +1,128 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StackingAction.cc
+/// \brief Implementation of the B1StackingAction class
+
+#include "StackingAction.hh"
+#include "B1RunAction.hh"
+#include "B1DetectorConstruction.hh"
+
+#include "G4Track.hh"
+#include "G4RunManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1StackingAction::B1StackingAction(B1RunAction* runAction)
+: G4UserStackingAction(),
+  fRunAction(runAction),
+  fMessenger(0),
+  fEnergyThreshold(0.),
+  fKillOutside(true),
+  fHaveLattice(false)
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B1StackingAction::~B1StackingAction()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack
+B1StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  // keep the primaries
+  if (track->GetParentID() == 0) return fUrgent;
+
+  if (track->GetKineticEnergy() < fEnergyThreshold) {
+    fRunAction->CountKilledBelowThreshold();
+    return fKill;
+  }
+
+  if (fKillOutside) {
+    if (!fHaveLattice) {
+      const B1DetectorConstruction* detectorConstruction
+        = static_cast<const B1DetectorConstruction*>
+          (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+      fLatticeLower = detectorConstruction->GetLatticeLower();
+      fLatticeUpper = detectorConstruction->GetLatticeUpper();
+      fHaveLattice = true;
+    }
+    if (MovingAway(track->GetPosition(), track->GetMomentumDirection())) {
+      fRunAction->CountKilledOutsideLattice();
+      return fKill;
+    }
+  }
+
+  return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B1StackingAction::MovingAway(const G4ThreeVector& position,
+                                    const G4ThreeVector& direction) const
+{
+  // a straight line from outside a box along an axis, heading further out
+  // along it, never reaches the box. A track is only near enough to a
+  // straight line: scattering in the world air can still turn it back, so
+  // this is an approximation that can lose a little dose
+  for (G4int axis = 0; axis < 3; ++axis) {
+    if (position[axis] < fLatticeLower[axis] && direction[axis] <= 0.) return true;
+    if (position[axis] > fLatticeUpper[axis] && direction[axis] >= 0.) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1StackingAction::DefineCommands()
+{
+  fMessenger
+    = new G4GenericMessenger(this, "/B1/stack/", "Secondary killing");
+
+  auto& thresholdCmd
+    = fMessenger->DeclarePropertyWithUnit("energyThreshold", "keV",
+                                          fEnergyThreshold,
+                                          "Kill secondaries below this kinetic energy.");
+  thresholdCmd.SetParameterName("threshold", true);
+  thresholdCmd.SetRange("threshold>=0.");
+  thresholdCmd.SetDefaultValue("0.");
+
+  auto& outsideCmd
+    = fMessenger->DeclareProperty("killOutside", fKillOutside,
+                                  "Kill secondaries outside the pixel lattice that move away from it.");
+  outsideCmd.SetParameterName("kill", true);
+  outsideCmd.SetDefaultValue("true");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
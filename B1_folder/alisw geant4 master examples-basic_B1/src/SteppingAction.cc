@@ -27,7 +27,6 @@
 /// \file B1SteppingAction.cc
 /// \brief Implementation of the B1SteppingAction class
 
-#include <vector>
 #include <iostream>
 
 #include "B1SteppingAction.hh"
@@ -59,24 +58,24 @@ void B1SteppingAction::UserSteppingAction(const G4Step* step)
     const B1DetectorConstruction* detectorConstruction
       = static_cast<const B1DetectorConstruction*>
         (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
-    fScoringVolume = detectorConstruction->GetScoringVolume();   
+    for (G4LogicalVolume* vol: detectorConstruction->GetScoringVolume()) {
+      fScoringVolume.insert(vol);
+    }
   }
 
   // get volume of the current step
-  G4LogicalVolume* volume 
-    = step->GetPreStepPoint()->GetTouchableHandle()
-      ->GetVolume()->GetLogicalVolume();
+  const G4TouchableHandle& touchable = step->GetPreStepPoint()->GetTouchableHandle();
+  G4LogicalVolume* volume = touchable->GetVolume()->GetLogicalVolume();
       
-  // check if we are in scoring volume using a look to go through the list of scoring volumes
-  int check{0};
-  for (G4LogicalVolume * vol: fScoringVolume) {
-    if (volume == vol) ++check;
-  }
-  if (check == 0) return;
+  // check if we are in a scoring volume
+  if (fScoringVolume.count(volume) == 0) return;
 
   // collect energy deposited in this step
   G4double edepStep = step->GetTotalEnergyDeposit();
   fEventAction->AddEdep(edepStep);  
+
+  // and in the diode, whose envelope (the pixel) is two levels up
+  if (edepStep > 0.) fEventAction->AddDiodeEdep(touchable->GetCopyNumber(2), edepStep);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,190 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "RunStatistics.hpp"
+
+/*
+Checkpoints for long runs. A checkpoint holds the statistics of every track simulated so far and the position in the
+random number stream, so a run that was killed can carry on from where it stopped. As every track has its own
+generator (see TrackRandom.hpp) the position is just the number of the next track (a shard of a run does not start
+at track 0), and a resumed run gives exactly the answer an uninterrupted run would have.
+
+The file is a small binary file of little endian 64 bit fields:
+
+        magic "HITSCKPT", format version
+        length of the run key, the run key
+        seed, next track
+        count, sum, sumSquares, number of histogram bins, the bins
+        number of weight bins, the weights and squared weights as the bits of doubles (none for unweighted runs)
+        FNV-1a checksum of everything before it
+
+It is written under a temporary name and renamed over the old checkpoint, so there is always one whole checkpoint on
+disk even if the run is killed while writing.
+*/
+
+const char checkpointMagic[8]{'H', 'I', 'T', 'S', 'C', 'K', 'P', 'T'};
+const std::uint64_t checkpointFormat{2};
+
+inline void appendWord(std::vector<unsigned char>& buffer, std::uint64_t word)
+{
+    for(int i{0}; i < 8; ++i) {buffer.push_back(static_cast<unsigned char>(word >> (8 * i)));}
+}
+
+inline std::uint64_t doubleBits(double value)
+{
+    std::uint64_t word{0};
+    std::memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+inline double bitsDouble(std::uint64_t word)
+{
+    double value{0};
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+inline bool takeWord(const std::vector<unsigned char>& buffer, std::size_t& position, std::uint64_t& word)
+{
+    if(position + 8 > buffer.size()) {return false;}
+    word = 0;
+    for(int i{0}; i < 8; ++i) {word |= static_cast<std::uint64_t>(buffer[position + i]) << (8 * i);}
+    position += 8;
+    return true;
+}
+
+inline std::uint64_t checksum(const std::vector<unsigned char>& buffer, std::size_t length)
+{
+    std::uint64_t hash{0xcbf29ce484222325ULL};
+    for(std::size_t i{0}; i < length; ++i)
+    {
+        hash ^= buffer[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+This function writes a checkpoint
+
+inputs:
+        path: the checkpoint file
+        key: the key of the run, as used for the result store, so a checkpoint is never resumed by a different run
+        seed: the seed of the run
+        nextTrack: the number of the first track that has not been simulated
+        stats: RunStatistics, the statistics of the tracks simulated so far
+
+outputs:
+        bool, true if the checkpoint was written
+*/
+
+inline bool writeCheckpoint(const std::string& path, const std::string& key, std::uint64_t seed, long long nextTrack,
+                            const RunStatistics& stats)
+{
+    std::vector<unsigned char> buffer(checkpointMagic, checkpointMagic + 8);
+    appendWord(buffer, checkpointFormat);
+    appendWord(buffer, key.size());
+    buffer.insert(buffer.end(), key.begin(), key.end());
+    appendWord(buffer, seed);
+    appendWord(buffer, nextTrack);
+    appendWord(buffer, stats.count);
+    appendWord(buffer, stats.sum);
+    appendWord(buffer, stats.sumSquares);
+    appendWord(buffer, stats.histogram.size());
+    for(long long bin : stats.histogram) {appendWord(buffer, bin);}
+    appendWord(buffer, stats.weights.size());
+    for(double bin : stats.weights) {appendWord(buffer, doubleBits(bin));}
+    for(double bin : stats.weightsSquared) {appendWord(buffer, doubleBits(bin));}
+    appendWord(buffer, checksum(buffer, buffer.size()));
+
+    std::string temporary{path + ".tmp"};
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        if(!file) {return false;}
+    }
+    std::error_code error{};
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+/*
+This function reads a checkpoint back
+
+inputs:
+        path: the checkpoint file
+        key: the key of the run that wants to resume
+        seed: the seed of that run
+        nextTrack: long long called by reference, set to the number of the first track left to simulate
+        stats: RunStatistics called by reference, replaced by the checkpointed statistics if they can be used
+
+outputs:
+        bool, true if there was a whole checkpoint for this run
+*/
+
+inline bool readCheckpoint(const std::string& path, const std::string& key, std::uint64_t seed, long long& nextTrack,
+                           RunStatistics& stats)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file) {return false;}
+    std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::size_t position{8};
+    std::uint64_t word{0};
+    if(buffer.size() < 16 || std::memcmp(buffer.data(), checkpointMagic, 8) != 0) {return false;}
+    if(!takeWord(buffer, position, word) || word != checkpointFormat) {return false;}
+
+    //the stored checksum covers everything before it
+    std::uint64_t stored{0};
+    std::size_t end{buffer.size() - 8};
+    takeWord(buffer, end, stored);
+    if(stored != checksum(buffer, buffer.size() - 8)) {return false;}
+
+    if(!takeWord(buffer, position, word) || position + word > buffer.size()) {return false;}
+    std::string storedKey(buffer.begin() + position, buffer.begin() + position + word);
+    position += word;
+    if(storedKey != key) {return false;}
+    if(!takeWord(buffer, position, word) || word != seed) {return false;}
+
+    RunStatistics read{};
+    std::uint64_t next{0};
+    std::uint64_t fields[4]{};
+    if(!takeWord(buffer, position, next)) {return false;}
+    for(std::uint64_t& field : fields)
+    {
+        if(!takeWord(buffer, position, field)) {return false;}
+    }
+    read.count = static_cast<long long>(fields[0]);
+    read.sum = static_cast<long long>(fields[1]);
+    read.sumSquares = static_cast<long long>(fields[2]);
+
+    read.histogram.resize(fields[3]);
+    for(long long& bin : read.histogram)
+    {
+        if(!takeWord(buffer, position, word)) {return false;}
+        bin = static_cast<long long>(word);
+    }
+    if(!takeWord(buffer, position, word) || word > buffer.size()) {return false;}
+    read.weights.resize(word);
+    read.weightsSquared.resize(word);
+    for(std::vector<double>* bins : {&read.weights, &read.weightsSquared})
+    {
+        for(double& bin : *bins)
+        {
+            if(!takeWord(buffer, position, word)) {return false;}
+            bin = bitsDouble(word);
+        }
+    }
+    nextTrack = static_cast<long long>(next);
+    stats = read;
+    return true;
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef CLUSTERING_HPP
+#define CLUSTERING_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/*
+Grouping of the hit sensors of an event into clusters of neighbouring sensors. One track can fire sensors that sit next
+to each other, most often a sensor and the offset sensor half a pixel along in the next layer, and these are better
+counted as one cluster than as separate hits.
+
+Two sensors are neighbours if their centres are at most one pixel apart along every axis. Within its own row (2D) or
+layer (3D) a pixel has the 2 pixels beside it, or the 8 around it. The rows or layers next to it are offset by half a
+pixel, so in each of them it only touches the 2 (2D) or 4 (3D) pixels nearest to it, making 6 neighbours in 2D and 16
+in 3D. Rows or layers further away are more than a pixel apart.
+
+The clusters are found with union-find over the hits of the event. An arena holds everything for up to Capacity hits
+in fixed arrays, so one arena per thread is reused for every event without allocating. An event with more hits than
+that only has its first Capacity hits clustered, and the arena counts these events so they can be reported.
+*/
+
+/*
+This function finds if two pixels are neighbours
+
+inputs:
+        pixels: the coordinates of the pixel centres, as filled in by createCoords
+        first, second: int, the ids of the two pixels
+        spacing: the size of a pixel along each axis
+
+outputs:
+        bool, true if the pixels are different and neighbours
+*/
+
+template <typename Pixels, std::size_t Dim>
+bool latticeNeighbours(const Pixels& pixels, int first, int second, const std::array<double, Dim>& spacing)
+{
+    if(first == second) {return false;}
+    for(std::size_t axis{0}; axis < Dim; ++axis)
+    {
+        //the small allowance keeps pixels exactly one spacing apart as neighbours despite rounding
+        if(std::abs(pixels[first][axis] - pixels[second][axis]) > spacing[axis] * (1 + 1e-9)) {return false;}
+    }
+    return true;
+}
+
+template <std::size_t Capacity>
+class ClusterArena
+{
+public:
+    /*
+    This function groups the hits of an event into clusters, only the first Capacity hits are used
+
+    inputs:
+            hits: the ids of the hit pixels
+            adjacent: called as adjacent(first id, second id), true if the two pixels are neighbours
+
+    outputs:
+            int, the number of clusters, their sizes are then given by clusterSize
+    */
+
+    template <typename Adjacent>
+    int cluster(const std::vector<int>& hits, Adjacent adjacent)
+    {
+        int count{static_cast<int>(std::min(hits.size(), Capacity))};
+        fTruncated = hits.size() > Capacity;
+        if(fTruncated) {++fTruncatedEvents;}
+        for(int i{0}; i < count; ++i)
+        {
+            fParent[i] = i;
+            fSize[i] = 1;
+        }
+        for(int i{1}; i < count; ++i)
+        {
+            for(int j{0}; j < i; ++j)
+            {
+                if(adjacent(hits[i], hits[j])) {unite(i, j);}
+            }
+        }
+
+        fClusters = 0;
+        for(int i{0}; i < count; ++i)
+        {
+            if(fParent[i] == i) {fClusterSizes[fClusters++] = fSize[i];}
+        }
+        return fClusters;
+    }
+
+    //number of hits in a cluster of the last event
+    int clusterSize(int cluster) const
+    {
+        return fClusterSizes[cluster];
+    }
+
+    //true if the last event had more hits than the arena holds
+    bool truncated() const
+    {
+        return fTruncated;
+    }
+
+    //number of events so far with more hits than the arena holds
+    long long truncatedEvents() const
+    {
+        return fTruncatedEvents;
+    }
+
+private:
+    int find(int i)
+    {
+        //path halving, every other node on the way up is pointed at its grandparent
+        while(fParent[i] != i)
+        {
+            fParent[i] = fParent[fParent[i]];
+            i = fParent[i];
+        }
+        return i;
+    }
+
+    void unite(int first, int second)
+    {
+        first = find(first);
+        second = find(second);
+        if(first == second) {return;}
+        if(fSize[first] < fSize[second]) {std::swap(first, second);}
+        fParent[second] = first;
+        fSize[first] += fSize[second];
+    }
+
+    std::array<int, Capacity> fParent{};
+    std::array<int, Capacity> fSize{};
+    std::array<int, Capacity> fClusterSizes{};
+    int fClusters{0};
+    bool fTruncated{false};
+    long long fTruncatedEvents{0};
+};
+
+#endif
@@ -29,11 +29,15 @@
 
 #include <array>
 #include <vector>
+#include <sstream>
 #include <iostream>
 #include <math.h>
 
 
 #include "B1DetectorConstruction.hh"
+#include "PixelParameterisation.hh"
+#include "DiodeSD.hh"
+#include "GeometryCache.hh"
 
 #include "G4RunManager.hh"
 #include "G4NistManager.hh"
@@ -44,13 +48,19 @@
 #include "G4Sphere.hh"
 #include "G4Trd.hh"
 #include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4SDManager.hh"
+#include "G4Region.hh"
+#include "G4ProductionCuts.hh"
 #include "G4SystemOfUnits.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B1DetectorConstruction::B1DetectorConstruction()
-: G4VUserDetectorConstruction()
+: G4VUserDetectorConstruction(),
+  fNumberOfPixels(0)
 { }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -69,8 +79,14 @@ G4VPhysicalVolume* B1DetectorConstruction::Construct()
   //
   G4double env_sizeX = 29, env_sizeY = 61, env_sizeZ = 20;
   G4Material* env_mat = nist->FindOrBuildMaterial("G4_AIR");
+
+  // Version of the components built below, part of the geometry cache key:
+  // bump it with any change to their sizes, materials or placements
+  //
+  const G4int geometryVersion = 1;
    
-  // Option to switch on/off checking of volumes overlaps
+  // Option to switch on/off checking of volumes overlaps, they are only
+  // checked when the geometry is built, not when it is read from the cache
   //
   G4bool checkOverlaps = true;
 
@@ -79,6 +95,30 @@ G4VPhysicalVolume* B1DetectorConstruction::Construct()
   //
   constexpr int len {4};
   constexpr int lenCubed {len * len * len};
+  fNumberOfPixels = lenCubed;
+
+  //
+  // Geometry cache, the built geometry is written to GDML once for each layout
+  // and read back on the later runs. The key holds the versions of the
+  // components and of the lattice positions, and every layout parameter, so a
+  // changed geometry gets a new cache, built with the overlap checks
+  //
+  std::ostringstream layout;
+  layout << "combined geometry=" << geometryVersion
+         << " lattice=" << B1PixelParameterisation::kVersion
+         << " len=" << len
+         << " env=" << env_sizeX << "," << env_sizeY << "," << env_sizeZ
+         << " " << env_mat->GetName();
+  B1GeometryCache cache(layout.str());
+
+  if ( G4VPhysicalVolume* cachedWorld = cache.Read() ) {
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    fScoringVolume.push_back(store->GetVolume("diodeInner"));
+    B1PixelParameterisation(len, env_sizeX, env_sizeY, env_sizeZ)
+      .GetExtent(fLatticeLower, fLatticeUpper);
+    DefineRegions(store->GetVolume("Envelope"));
+    return cachedWorld;
+  }
 
   G4double world_sizeX = len*env_sizeX;
   G4double world_sizeY = len*env_sizeY;
@@ -107,34 +147,9 @@ G4VPhysicalVolume* B1DetectorConstruction::Construct()
               
 ///////////////////////////////////////////////////////////////////////////////////
 
-////Creating an array of points for components inside the envelope////
-///Loop for envelope///
-
-
-std::array<std::array<G4double, 3>, lenCubed> pixelLocations{};
-
-for(int i{0}; i < len; i += 2)
-{
-  for(int j{0}; j < len; ++j)
-  {
-    for(int k{0}; k < len; ++k)
-    {
-      pixelLocations[k + len * j + len * len * i][2] = ((len / 2) - i) * env_sizeZ;
-      pixelLocations[k + len * j + len * len * i][1] = ((len / 2) - j) * env_sizeY;
-      pixelLocations[k + len * j + len * len * i][0] = ((len / 2) - k) * env_sizeX;
-
-      //every other z layer is offset
-      pixelLocations[k + len * j + len * len * (i + 1)][2] = ((len / 2) - (i+1)) * env_sizeZ;
-      pixelLocations[k + len * j + len * len * (i + 1)][1] = ((len / 2) - (j + 0.5)) * env_sizeY;
-      pixelLocations[k + len * j + len * len * (i + 1)][0] = ((len / 2) - (k + 0.5)) * env_sizeX;
-    }
-  }
-}
-
-//using the envelope defined in B1DetectorConstruction
+//the envelope and everything in it are built once, the one envelope logical volume is then placed at every pixel
+//location at the end, so the components are not built again for each pixel
 
-for (G4int i{0}; i < lenCubed; ++i)
-{
   G4Box* solidEnv =    
     new G4Box("Envelope",                    
         0.5*env_sizeX, 0.5*env_sizeY, 0.5*env_sizeZ);
@@ -143,16 +158,6 @@ for (G4int i{0}; i < lenCubed; ++i)
     new G4LogicalVolume(solidEnv,            //its solid
                         env_mat,             //its material
                         "Envelope");       
-
-  new G4PVPlacement(0,                       //no rotation
-                    G4ThreeVector(pixelLocations[i][0], pixelLocations[i][1], pixelLocations[i][2]),         
-                    logicEnv,                //its logical volume    //idk if this will mess up the mothervolumes for each component
-                    "Envelope",              //its name
-                    logicWorld,              //its mother  volume
-                    false,                   //no boolean operation
-                    i,                       //copy number
-                    checkOverlaps);
-
   
   //     
   // Resistor
@@ -177,19 +182,37 @@ for (G4int i{0}; i < lenCubed; ++i)
   G4RotationMatrix* rotationMatrixAcross = new G4RotationMatrix();
   rotationMatrixAcross->rotateX(90.*deg);
 
+  //one resistor, the inner metal inside the outer plastic, placed at each of the points
+
+  G4Tubs* solidShape3 =    
+      new G4Tubs("Resistor_out", 
+        0., outer_res_radius, outer_res_height/2, 0 * deg, 360. * deg);
+                      
+  G4LogicalVolume* logicResOut =                         
+    new G4LogicalVolume(solidShape3, res_mat_outer, "Resistor_out", 0, 0, 0);           //its name
+
+  G4Tubs* solidShape4 =    
+    new G4Tubs("Resistor_in", 
+      0., inner_res_radius, inner_res_height/2, 0 * deg, 360. * deg);
+                      
+  G4LogicalVolume* logicResIn = 
+    new G4LogicalVolume(solidShape4, res_mat_inner, "Resistor_in", 0, 0, 0);           
+               
+  new G4PVPlacement(0,                       //no rotation
+                    G4ThreeVector(0, 0, 0),                    //at position
+                    logicResIn,             //its logical volume
+                    "Resistor_in",                //its name
+                    logicResOut,                //its mother  volume
+                    false,                   //no boolean operation
+                    0,                       //copy number
+                    checkOverlaps); 
+
   ////Loop to change the points///
 
   for (G4int copyNo=0; copyNo<7; copyNo++) {
 
       G4ThreeVector pos_res_outer = G4ThreeVector(resistor[copyNo][0], resistor[copyNo][1], resistor[copyNo][2]);
 
-      G4Tubs* solidShape3 =    
-          new G4Tubs("Resistor_out", 
-            0., outer_res_radius, outer_res_height/2, 0 * deg, 360. * deg);
-                      
-      G4LogicalVolume* logicResOut =                         
-        new G4LogicalVolume(solidShape3, res_mat_outer, "Resistor_out", 0, 0, 0);           //its name
-
     if (copyNo<5)
     {
       new G4PVPlacement(rotationMatrixUp,                       //no rotation
@@ -212,24 +235,6 @@ for (G4int i{0}; i < lenCubed; ++i)
                         copyNo,                       //copy number
                         checkOverlaps);          //overlaps checking
     }
-
-        //Inner metal of resistor
-
-  G4Tubs* solidShape4 =    
-    new G4Tubs("Resistor_in", 
-      0., inner_res_radius, inner_res_height/2, 0 * deg, 360. * deg);
-                      
-  G4LogicalVolume* logicResIn = 
-    new G4LogicalVolume(solidShape4, res_mat_inner, "Resistor_in", 0, 0, 0);           
-               
-  new G4PVPlacement(0,                       //no rotation
-                    G4ThreeVector(0, 0, 0),                    //at position
-                    logicResIn,             //its logical volume
-                    "Resistor_in",                //its name
-                    logicResOut,                //its mother  volume
-                    false,                   //no boolean operation
-                    0,                       //copy number
-                    checkOverlaps); 
     }
 
   ///Capacitor///////
@@ -252,12 +257,30 @@ for (G4int i{0}; i < lenCubed; ++i)
     0., outer_cap_radius, outer_cap_height/2, 90. * deg, 360. * deg);
                     
 
+  G4LogicalVolume* logicCapOut = 
+    new G4LogicalVolume(solidShape1, cap_mat_outer, "Capacitor_out", 0, 0, 0);           
+
+   ///Inner Capacitor///
+
+  G4Tubs* solidShape2 =    
+    new G4Tubs("Capacitor_in", 
+    0., inner_cap_radius, inner_cap_height/2, 0. * deg, 360. * deg);
+                      
+  G4LogicalVolume* logicCapIn = 
+    new G4LogicalVolume(solidShape2, cap_mat_inner, "Capacitor_in", 0, 0, 0); 
+              
+  new G4PVPlacement(0,                       //no rotation
+                    G4ThreeVector(0, 0, 0),                    //at position
+                    logicCapIn,             //its logical volume
+                    "Capacitor_in",                //its name
+                    logicCapOut,                //its mother  volume
+                    false,                   //no boolean operation
+                    0,                       //copy number
+                    checkOverlaps);  
+
   for (G4int copyNo=0; copyNo<3; copyNo++) {
 
     G4ThreeVector pos_cap_outer = G4ThreeVector(capacitor[copyNo][0], capacitor[copyNo][1], capacitor[copyNo][2]);
-            
-    G4LogicalVolume* logicCapOut = 
-      new G4LogicalVolume(solidShape1, cap_mat_outer, "Capacitor_out", 0, 0, 0);           
                   
     new G4PVPlacement(0,                       //no rotation
                       pos_cap_outer,                    //at position
@@ -267,24 +290,6 @@ for (G4int i{0}; i < lenCubed; ++i)
                       false,                   //no boolean operation
                       copyNo,                       //copy number
                       checkOverlaps);          //overlaps checking
-
-     ///Inner Capacitor///
-
-    G4Tubs* solidShape2 =    
-      new G4Tubs("Capacitor_in", 
-      0., inner_cap_radius, inner_cap_height/2, 0. * deg, 360. * deg);
-                        
-    G4LogicalVolume* logicCapIn = 
-      new G4LogicalVolume(solidShape2, cap_mat_inner, "Capacitor_in", 0, 0, 0); 
-                
-    new G4PVPlacement(0,                       //no rotation
-                      G4ThreeVector(0, 0, 0),                    //at position
-                      logicCapIn,             //its logical volume
-                      "Capacitor_in",                //its name
-                      logicCapOut,                //its mother  volume
-                      false,                   //no boolean operation
-                      0,                       //copy number
-                      checkOverlaps);  
     }
 
 
@@ -300,23 +305,10 @@ for (G4int i{0}; i < lenCubed; ++i)
   new G4Box("chipInner",                       //its name
       0.5 * chipOuterX, 0.5 * chipOuterY, 0.5 * chipOuterZ);  
 
-  for (G4int copyNo=0; copyNo<4; copyNo++) {
-
-      G4ThreeVector pos_chip_outer = G4ThreeVector(chip[copyNo][0], chip[copyNo][1], chip[copyNo][2]);
-              
-        G4LogicalVolume* logicChipOuter =                         
-          new G4LogicalVolume(chipOuter,         //its solid
-                              chipOuterMat,          //its material
-                              "chipOuter");           //its name
-                    
-        new G4PVPlacement(0,                       //no rotation
-                          pos_chip_outer,                    //at position
-                          logicChipOuter,             //its logical volume
-                          "chipOuter",                //its name
-                          logicEnv,                //its mother  volume
-                          false,                   //no boolean operation
-                          copyNo,                       //copy number
-                          checkOverlaps);          //overlaps checking
+  G4LogicalVolume* logicChipOuter =                         
+    new G4LogicalVolume(chipOuter,         //its solid
+                        chipOuterMat,          //its material
+                        "chipOuter");           //its name
 
   G4Material* chipInnerMat = nist->FindOrBuildMaterial("G4_Si");  //not sure if this is the name of a real plastic
   G4double chipInnerX {8};   //defining x, y, z lengths of the components inside the chip
@@ -340,6 +332,19 @@ for (G4int i{0}; i < lenCubed; ++i)
                     false,                //no boolean operation
                     0,                    //copy number? presumably the number of times it appears which will be more than 0     
                     checkOverlaps);
+
+  for (G4int copyNo=0; copyNo<4; copyNo++) {
+
+      G4ThreeVector pos_chip_outer = G4ThreeVector(chip[copyNo][0], chip[copyNo][1], chip[copyNo][2]);
+                    
+        new G4PVPlacement(0,                       //no rotation
+                          pos_chip_outer,                    //at position
+                          logicChipOuter,             //its logical volume
+                          "chipOuter",                //its name
+                          logicEnv,                //its mother  volume
+                          false,                   //no boolean operation
+                          copyNo,                       //copy number
+                          checkOverlaps);          //overlaps checking
     }
 
 
@@ -531,11 +536,69 @@ plastic seperator
 
   fScoringVolume.push_back(logicDiodeInner);
 
-}
+  //placing the envelope at every pixel location with one parameterised volume, the parameterisation works out the
+  //position of each envelope from its copy number, which is the index of its pixel, so no table of locations is kept
+
+  B1PixelParameterisation* pixelParam =
+    new B1PixelParameterisation(len, env_sizeX, env_sizeY, env_sizeZ);
+  pixelParam->GetExtent(fLatticeLower, fLatticeUpper);
+
+  new G4PVParameterised("Envelope",              //its name
+                        logicEnv,                //its logical volume
+                        logicWorld,              //its mother  volume
+                        kUndefined,              //no single axis, the lattice is 3D
+                        lenCubed,                //number of copies
+                        pixelParam,              //the parameterisation
+                        checkOverlaps);          //overlaps checking
+
+  DefineRegions(logicEnv);
+
+  // only the freshly built geometry goes to the cache
+  cache.Write(physWorld);
+
   //
   //always return the physical World
   //
   return physWorld;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DetectorConstruction::DefineRegions(G4LogicalVolume* logicEnv)
+{
+  // Regions, so the silicon and the passive parts can have their own production cuts. The passive region is
+  // everything in the envelope except the diode silicon, which is a region of its own. The cuts below are the
+  // defaults, they can be changed from a macro with /run/setCutForRegion Silicon (or Passive) <cut> <unit>
+  G4Region* siliconRegion = new G4Region("Silicon");
+  for (G4LogicalVolume* vol: fScoringVolume) {
+    siliconRegion->AddRootLogicalVolume(vol);
+  }
+  G4ProductionCuts* siliconCuts = new G4ProductionCuts();
+  siliconCuts->SetProductionCut(1.*um);
+  siliconRegion->SetProductionCuts(siliconCuts);
+
+  G4Region* passiveRegion = new G4Region("Passive");
+  passiveRegion->AddRootLogicalVolume(logicEnv);
+  G4ProductionCuts* passiveCuts = new G4ProductionCuts();
+  passiveCuts->SetProductionCut(1.*mm);
+  passiveRegion->SetProductionCuts(passiveCuts);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DetectorConstruction::ConstructSDandField()
+{
+  // Sensitive detector for the diode silicon, every scoring volume records
+  // its hits into the one hits collection
+
+  G4String diodeSDname = "B1/DiodeSD";
+  B1DiodeSD* diodeSD = new B1DiodeSD(diodeSDname,
+                                     "DiodeHitsCollection");
+  G4SDManager::GetSDMpointer()->AddNewDetector(diodeSD);
+
+  for (G4LogicalVolume* vol: fScoringVolume) {
+    SetSensitiveDetector(vol, diodeSD);
+  }
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
\ No newline at end of file
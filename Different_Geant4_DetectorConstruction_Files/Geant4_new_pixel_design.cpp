@@ -29,11 +29,15 @@
 
 #include <array>
 #include <vector>
+#include <sstream>
 #include <iostream>
 #include <math.h>
 
 
 #include "B1DetectorConstruction.hh"
+#include "PixelParameterisation.hh"
+#include "DiodeSD.hh"
+#include "GeometryCache.hh"
 
 #include "G4RunManager.hh"
 #include "G4NistManager.hh"
@@ -44,13 +48,19 @@
 #include "G4Sphere.hh"
 #include "G4Trd.hh"
 #include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4SDManager.hh"
+#include "G4Region.hh"
+#include "G4ProductionCuts.hh"
 #include "G4SystemOfUnits.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B1DetectorConstruction::B1DetectorConstruction()
-: G4VUserDetectorConstruction()
+: G4VUserDetectorConstruction(),
+  fNumberOfPixels(0)
 { }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -69,8 +79,14 @@ G4VPhysicalVolume* B1DetectorConstruction::Construct()
   //
   G4double env_sizeX = 32.5, env_sizeY = 98.5, env_sizeZ = 22;
   G4Material* env_mat = nist->FindOrBuildMaterial("G4_AIR");
+
+  // Version of the components built below, part of the geometry cache key:
+  // bump it with any change to their sizes, materials or placements
+  //
+  const G4int geometryVersion = 1;
    
-  // Option to switch on/off checking of volumes overlaps
+  // Option to switch on/off checking of volumes overlaps, they are only
+  // checked when the geometry is built, not when it is read from the cache
   //
   G4bool checkOverlaps = true;
 
@@ -79,6 +95,30 @@ G4VPhysicalVolume* B1DetectorConstruction::Construct()
   //
   constexpr int len {10};
   constexpr int lenCubed {len * len * len};
+  fNumberOfPixels = lenCubed;
+
+  //
+  // Geometry cache, the built geometry is written to GDML once for each layout
+  // and read back on the later runs. The key holds the versions of the
+  // components and of the lattice positions, and every layout parameter, so a
+  // changed geometry gets a new cache, built with the overlap checks
+  //
+  std::ostringstream layout;
+  layout << "new_pixel_design geometry=" << geometryVersion
+         << " lattice=" << B1PixelParameterisation::kVersion
+         << " len=" << len
+         << " env=" << env_sizeX << "," << env_sizeY << "," << env_sizeZ
+         << " " << env_mat->GetName();
+  B1GeometryCache cache(layout.str());
+
+  if ( G4VPhysicalVolume* cachedWorld = cache.Read() ) {
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    fScoringVolume.push_back(store->GetVolume("diodeInner"));
+    B1PixelParameterisation(len, env_sizeX, env_sizeY, env_sizeZ)
+      .GetExtent(fLatticeLower, fLatticeUpper);
+    DefineRegions(store->GetVolume("Envelope"));
+    return cachedWorld;
+  }
 
   G4double world_sizeX = len*env_sizeX;
   G4double world_sizeY = len*env_sizeY;
@@ -107,452 +147,475 @@ G4VPhysicalVolume* B1DetectorConstruction::Construct()
               
 ///////////////////////////////////////////////////////////////////////////////////
 
-////Creating an array of points for components inside the envelope////
-///Loop for envelope///
+  //the envelope and everything in it are built once, the one envelope logical volume is then placed at every pixel
+  //location at the end, so the components are not built again for each pixel
 
+  G4Box* solidEnv =    
+    new G4Box("Envelope",                    
+        0.5*env_sizeX, 0.5*env_sizeY, 0.5*env_sizeZ);
+      
+  G4LogicalVolume* logicEnv =
+    new G4LogicalVolume(solidEnv,            //its solid
+                        env_mat,             //its material
+                        "Envelope");       
+  
+  //     
+  // Resistor
+  //
+  std::array<std::array<G4double, 4>, 8> resistor = {{{2.5, -33, -3}, {2.5, -15, -3}, {2.5, 3, -3}, {-10, 45, -3}, {1, 45, -3}, {-7, 24, -3}, {12.5, 19.5, -3}, {5, 30, 3}}};
 
-  std::array<std::array<G4double, 3>, lenCubed> pixelLocations{};
+  G4Material* res_mat_outer = nist->FindOrBuildMaterial("G4_POLYCARBONATE");
 
-  for(int i{0}; i < len; i += 2)
-  {
-    for(int j{0}; j < len; ++j)
-    {
-      for(int k{0}; k < len; ++k)
-      {
-        pixelLocations[k + len * j + len * len * i][2] = ((len / 2) - i) * env_sizeZ;
-        pixelLocations[k + len * j + len * len * i][1] = ((len / 2) - j) * env_sizeY;
-        pixelLocations[k + len * j + len * len * i][0] = ((len / 2) - k) * env_sizeX;
-
-        //every other z layer is offset
-        pixelLocations[k + len * j + len * len * (i + 1)][2] = ((len / 2) - (i+1)) * env_sizeZ;
-        pixelLocations[k + len * j + len * len * (i + 1)][1] = ((len / 2) - (j + 0.5)) * env_sizeY;
-        pixelLocations[k + len * j + len * len * (i + 1)][0] = ((len / 2) - (k + 0.5)) * env_sizeX;
-      }
-    }
-  }
+  G4double outer_res_radius = 1.5;
+  G4double outer_res_height = 10;
 
-  //using the envelope defined in B1DetectorConstruction
+  //Inner metal of resistor
 
-  for (G4int i{0}; i < lenCubed; ++i)
-  {
-    G4Box* solidEnv =    
-      new G4Box("Envelope",                    
-          0.5*env_sizeX, 0.5*env_sizeY, 0.5*env_sizeZ);
-        
-    G4LogicalVolume* logicEnv =
-      new G4LogicalVolume(solidEnv,            //its solid
-                          env_mat,             //its material
-                          "Envelope");       
+  G4Material* res_mat_inner = nist->FindOrBuildMaterial("G4_Cu");
 
-    new G4PVPlacement(0,                       //no rotation
-                      G4ThreeVector(pixelLocations[i][0], pixelLocations[i][1], pixelLocations[i][2]),         
-                      logicEnv,                //its logical volume    //idk if this will mess up the mothervolumes for each component
-                      "Envelope",              //its name
-                      logicWorld,              //its mother  volume
-                      false,                   //no boolean operation
-                      i,                       //copy number
-                      checkOverlaps);
+  G4double inner_res_radius = 1.4;
+  G4double inner_res_height = 9.8;
 
-    
-    //     
-    // Resistor
-    //
-    std::array<std::array<G4double, 4>, 8> resistor = {{{2.5, -33, -3}, {2.5, -15, -3}, {2.5, 3, -3}, {-10, 45, -3}, {1, 45, -3}, {-7, 24, -3}, {12.5, 19.5, -3}, {5, 30, 3}}};
+  G4RotationMatrix* rotationMatrixAcross = new G4RotationMatrix();
+  rotationMatrixAcross->rotateY(90.*deg);
 
-    G4Material* res_mat_outer = nist->FindOrBuildMaterial("G4_POLYCARBONATE");
-  
-    G4double outer_res_radius = 1.5;
-    G4double outer_res_height = 10;
-  
-    //Inner metal of resistor
+  G4RotationMatrix* rotationMatrixUp = new G4RotationMatrix();
+  rotationMatrixUp->rotateX(90.*deg);
 
-    G4Material* res_mat_inner = nist->FindOrBuildMaterial("G4_Cu");
+    G4RotationMatrix* rotationMatrixDiag = new G4RotationMatrix();
+    rotationMatrixDiag->rotateX(90.*deg);
+    rotationMatrixDiag->rotateZ(45.*deg);
 
-    G4double inner_res_radius = 1.4;
-    G4double inner_res_height = 9.8;
+  //one resistor, the inner metal inside the outer plastic, placed at each of the points
 
-    G4RotationMatrix* rotationMatrixAcross = new G4RotationMatrix();
-    rotationMatrixAcross->rotateY(90.*deg);
+  G4Tubs* solidShape3 =    
+      new G4Tubs("Resistor_out", 
+        0., outer_res_radius, outer_res_height/2, 0 * deg, 360. * deg);
+                      
+  G4LogicalVolume* logicResOut =                         
+    new G4LogicalVolume(solidShape3, res_mat_outer, "Resistor_out", 0, 0, 0);
 
-    G4RotationMatrix* rotationMatrixUp = new G4RotationMatrix();
-    rotationMatrixUp->rotateX(90.*deg);
+  //inner part of resistor
 
-      G4RotationMatrix* rotationMatrixDiag = new G4RotationMatrix();
-      rotationMatrixDiag->rotateX(90.*deg);
-      rotationMatrixDiag->rotateZ(45.*deg);
+  G4Tubs* solidShape4 =    
+    new G4Tubs("Resistor_in", 
+      0., inner_res_radius, inner_res_height/2, 0 * deg, 360. * deg);
+                      
+  G4LogicalVolume* logicResIn = 
+    new G4LogicalVolume(solidShape4, res_mat_inner, "Resistor_in", 0, 0, 0);           
+              
+  new G4PVPlacement(0,                       //no rotation
+                    G4ThreeVector(0, 0, 0),                    //at position
+                    logicResIn,             //its logical volume
+                    "Resistor_in",                //its name
+                    logicResOut,                //its mother  volume
+                    false,                   //no boolean operation
+                    0,                       //copy number
+                    checkOverlaps); 
 
-    ////Loop to change the points///
+  ////Loop to change the points///
 
-    for (G4int copyNo=0; copyNo<8; copyNo++) {
+  for (G4int copyNo=0; copyNo<8; copyNo++) {
 
-        G4ThreeVector pos_res_outer = G4ThreeVector(resistor[copyNo][0], resistor[copyNo][1], resistor[copyNo][2]);
+      G4ThreeVector pos_res_outer = G4ThreeVector(resistor[copyNo][0], resistor[copyNo][1], resistor[copyNo][2]);
 
-        G4Tubs* solidShape3 =    
-            new G4Tubs("Resistor_out", 
-              0., outer_res_radius, outer_res_height/2, 0 * deg, 360. * deg);
-                        
-        G4LogicalVolume* logicResOut =                         
-          new G4LogicalVolume(solidShape3, res_mat_outer, "Resistor_out", 0, 0, 0);
+    if (copyNo<3) 
+    {
+        new G4PVPlacement(rotationMatrixDiag,                       //no rotation
+                        pos_res_outer,                    //at position
+                        logicResOut,             //its logical volume
+                        "Resistor_out",                //its name
+                        logicEnv,                //its mother  volume
+                        false,                   //no boolean operation
+                        copyNo,                       //copy number
+                        checkOverlaps); 
 
-          //inner part of resistor
+    }
+    else if (copyNo<6)
+    {
+      new G4PVPlacement(rotationMatrixAcross,                       //no rotation
+                        pos_res_outer,                    //at position
+                        logicResOut,             //its logical volume
+                        "Resistor_out",                //its name
+                        logicEnv,                //its mother  volume
+                        false,                   //no boolean operation
+                        copyNo,                       //copy number
+                        checkOverlaps);          //overlaps checking
+    }
+    else
+    {
+      new G4PVPlacement(rotationMatrixUp,                       //no rotation
+                        pos_res_outer,                    //at position
+                        logicResOut,             //its logical volume
+                        "Resistor_out",                //its name
+                        logicEnv,                //its mother  volume
+                        false,                   //no boolean operation
+                        copyNo,                       //copy number
+                        checkOverlaps);          //overlaps checking
+    }
+    }
 
-      if (copyNo<3) 
-      {
-          new G4PVPlacement(rotationMatrixDiag,                       //no rotation
-                          pos_res_outer,                    //at position
-                          logicResOut,             //its logical volume
-                          "Resistor_out",                //its name
-                          logicEnv,                //its mother  volume
-                          false,                   //no boolean operation
-                          copyNo,                       //copy number
-                          checkOverlaps); 
+  ///Capacitor///////
 
-      }
+  std::array<std::array<G4double, 3>, 5> capacitor = {{{-3.5, -46.5, -3}, {-3.5, -28.5, -3}, {-3.5, -10.5, -3}, {8.5, 19.5, -3}, {2.5, 41, -3}}};
 
-      if (copyNo>=3 && copyNo<6)
-      {
-        new G4PVPlacement(rotationMatrixAcross,                       //no rotation
-                          pos_res_outer,                    //at position
-                          logicResOut,             //its logical volume
-                          "Resistor_out",                //its name
-                          logicEnv,                //its mother  volume
-                          false,                   //no boolean operation
-                          copyNo,                       //copy number
-                          checkOverlaps);          //overlaps checking
-      }
-      else
-      {
-        new G4PVPlacement(rotationMatrixUp,                       //no rotation
-                          pos_res_outer,                    //at position
-                          logicResOut,             //its logical volume
-                          "Resistor_out",                //its name
-                          logicEnv,                //its mother  volume
-                          false,                   //no boolean operation
-                          copyNo,                       //copy number
-                          checkOverlaps);          //overlaps checking
-      }
-
-        G4Tubs* solidShape4 =    
-      new G4Tubs("Resistor_in", 
-        0., inner_res_radius, inner_res_height/2, 0 * deg, 360. * deg);
-                        
-      G4LogicalVolume* logicResIn = 
-        new G4LogicalVolume(solidShape4, res_mat_inner, "Resistor_in", 0, 0, 0);           
-                
-      new G4PVPlacement(0,                       //no rotation
-                      G4ThreeVector(0, 0, 0),                    //at position
-                      logicResIn,             //its logical volume
-                      "Resistor_in",                //its name
-                      logicResOut,                //its mother  volume
-                      false,                   //no boolean operation
-                      0,                       //copy number
-                      checkOverlaps); 
-      }
+  //Capacior
+  //Outer plastic of capacitor
+  G4Material* cap_mat_outer = nist->FindOrBuildMaterial("G4_POLYCARBONATE");
+  G4Material* cap_mat_inner = nist->FindOrBuildMaterial("G4_Al");
 
-    ///Capacitor///////
+  G4double outer_cap_radius = 1.5;
+  G4double outer_cap_height = 1;
 
-    std::array<std::array<G4double, 3>, 5> capacitor = {{{-3.5, -46.5, -3}, {-3.5, -28.5, -3}, {-3.5, -10.5, -3}, {8.5, 19.5, -3}, {2.5, 41, -3}}};
+  G4double inner_cap_radius = 1.4;
+  G4double inner_cap_height = 0.9;
 
-    //Capacior
-    //Outer plastic of capacitor
-    G4Material* cap_mat_outer = nist->FindOrBuildMaterial("G4_POLYCARBONATE");
-    G4Material* cap_mat_inner = nist->FindOrBuildMaterial("G4_Al");
-  
-    G4double outer_cap_radius = 1.5;
-    G4double outer_cap_height = 1;
+  G4Tubs* solidShape1 =    
+    new G4Tubs("Capacitor_out", 
+    0., outer_cap_radius, outer_cap_height/2, 90. * deg, 360. * deg);
+                    
+  G4LogicalVolume* logicCapOut = 
+    new G4LogicalVolume(solidShape1, cap_mat_outer, "Capacitor_out", 0, 0, 0);           
 
-    G4double inner_cap_radius = 1.4;
-    G4double inner_cap_height = 0.9;
+  ///Inner Capacitor///
 
-    G4Tubs* solidShape1 =    
-      new G4Tubs("Capacitor_out", 
-      0., outer_cap_radius, outer_cap_height/2, 90. * deg, 360. * deg);
+  G4Tubs* solidShape2 =    
+    new G4Tubs("Capacitor_in", 
+    0., inner_cap_radius, inner_cap_height/2, 0. * deg, 360. * deg);
                       
-
-    for (G4int copyNo=0; copyNo<5; copyNo++) {
-
-      G4ThreeVector pos_cap_outer = G4ThreeVector(capacitor[copyNo][0], capacitor[copyNo][1], capacitor[copyNo][2]);
+  G4LogicalVolume* logicCapIn = 
+    new G4LogicalVolume(solidShape2, cap_mat_inner, "Capacitor_in", 0, 0, 0); 
               
-      G4LogicalVolume* logicCapOut = 
-        new G4LogicalVolume(solidShape1, cap_mat_outer, "Capacitor_out", 0, 0, 0);           
-                    
-      new G4PVPlacement(0,                       //no rotation
-                        pos_cap_outer,                    //at position
-                        logicCapOut,             //its logical volume
-                        "Capacitor_out",                //its name
-                        logicEnv,                //its mother  volume
-                        false,                   //no boolean operation
-                        copyNo,                       //copy number
-                        checkOverlaps);          //overlaps checking
+  new G4PVPlacement(0,                       //no rotation
+                    G4ThreeVector(0, 0, 0),                    //at position
+                    logicCapIn,             //its logical volume
+                    "Capacitor_in",                //its name
+                    logicCapOut,                //its mother  volume
+                    false,                   //no boolean operation
+                    0,                       //copy number
+                    checkOverlaps);  
+
+  for (G4int copyNo=0; copyNo<5; copyNo++) {
+
+    G4ThreeVector pos_cap_outer = G4ThreeVector(capacitor[copyNo][0], capacitor[copyNo][1], capacitor[copyNo][2]);
+                  
+    new G4PVPlacement(0,                       //no rotation
+                      pos_cap_outer,                    //at position
+                      logicCapOut,             //its logical volume
+                      "Capacitor_out",                //its name
+                      logicEnv,                //its mother  volume
+                      false,                   //no boolean operation
+                      copyNo,                       //copy number
+                      checkOverlaps);          //overlaps checking
+    }
 
-      ///Inner Capacitor///
 
-      G4Tubs* solidShape2 =    
-        new G4Tubs("Capacitor_in", 
-        0., inner_cap_radius, inner_cap_height/2, 0. * deg, 360. * deg);
-                          
-      G4LogicalVolume* logicCapIn = 
-        new G4LogicalVolume(solidShape2, cap_mat_inner, "Capacitor_in", 0, 0, 0); 
-                  
-      new G4PVPlacement(0,                       //no rotation
-                        G4ThreeVector(0, 0, 0),                    //at position
-                        logicCapIn,             //its logical volume
-                        "Capacitor_in",                //its name
-                        logicCapOut,                //its mother  volume
-                        false,                   //no boolean operation
-                        0,                       //copy number
-                        checkOverlaps);  
-      }
+  /////For the chips/////
+  std::array<std::array<G4double, 3>, 6> chip = {{{2.5, -42, -4}, {2.5, -24, -4}, {2.5, -6, -4}, {2.5, 12, -4}, {2.5, 24, -4}, {2.5, 34, -4}}};
+
+  G4Material* chipOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
+  G4double chipOuterX {9}; //defining x, y, z lengths of the external plastic on the chip
+  G4double chipOuterY {7};
+  G4double chipOuterZ {4};
 
+  G4Box* chipOuter = 
+  new G4Box("chipInner",                       //its name
+      0.5 * chipOuterX, 0.5 * chipOuterY, 0.5 * chipOuterZ);  
 
-    /////For the chips/////
-    std::array<std::array<G4double, 3>, 6> chip = {{{2.5, -42, -4}, {2.5, -24, -4}, {2.5, -6, -4}, {2.5, 12, -4}, {2.5, 24, -4}, {2.5, 34, -4}}};
+  G4LogicalVolume* logicChipOuter =                         
+    new G4LogicalVolume(chipOuter,         //its solid
+                        chipOuterMat,          //its material
+                        "chipOuter");           //its name
 
-    G4Material* chipOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
-    G4double chipOuterX {9}; //defining x, y, z lengths of the external plastic on the chip
-    G4double chipOuterY {7};
-    G4double chipOuterZ {4};
+  G4Material* chipInnerMat = nist->FindOrBuildMaterial("G4_Si");  //not sure if this is the name of a real plastic
+  G4double chipInnerX {8};   //defining x, y, z lengths of the components inside the chip
+  G4double chipInnerY {6};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
+  G4double chipInnerZ {3};
 
-    G4Box* chipOuter = 
+  G4Box* chipInner = 
     new G4Box("chipInner",                       //its name
-        0.5 * chipOuterX, 0.5 * chipOuterY, 0.5 * chipOuterZ);  
+        0.5 * chipInnerX, 0.5 * chipInnerY, 0.5 * chipInnerZ);   //its size
+  
+  G4LogicalVolume* logicChipInner = 
+    new G4LogicalVolume(chipInner,         //?? not sure think thats its in diodeOuter above
+                        chipInnerMat,      //its material
+                        "chipInner");      //its name
+          
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, 0, 0),      //coordinate
+                    logicChipInner,      //it's logical volume
+                    "chipOuter",         //its name
+                    logicChipOuter,      //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);
+
+  for (G4int copyNo=0; copyNo<6; copyNo++) {
+
+      G4ThreeVector pos_chip_outer = G4ThreeVector(chip[copyNo][0], chip[copyNo][1], chip[copyNo][2]);
+                    
+        new G4PVPlacement(0,                       //no rotation
+                          pos_chip_outer,                    //at position
+                          logicChipOuter,             //its logical volume
+                          "chipOuter",                //its name
+                          logicEnv,                //its mother  volume
+                          false,                   //no boolean operation
+                          copyNo,                       //copy number
+                          checkOverlaps);          //overlaps checking
+    }
 
-    for (G4int copyNo=0; copyNo<6; copyNo++) {
 
-        G4ThreeVector pos_chip_outer = G4ThreeVector(chip[copyNo][0], chip[copyNo][1], chip[copyNo][2]);
-                
-          G4LogicalVolume* logicChipOuter =                         
-            new G4LogicalVolume(chipOuter,         //its solid
-                                chipOuterMat,          //its material
-                                "chipOuter");           //its name
-                      
-          new G4PVPlacement(0,                       //no rotation
-                            pos_chip_outer,                    //at position
-                            logicChipOuter,             //its logical volume
-                            "chipOuter",                //its name
-                            logicEnv,                //its mother  volume
-                            false,                   //no boolean operation
-                            copyNo,                       //copy number
-                            checkOverlaps);          //overlaps checking
-
-    G4Material* chipInnerMat = nist->FindOrBuildMaterial("G4_Si");  //not sure if this is the name of a real plastic
-    G4double chipInnerX {8};   //defining x, y, z lengths of the components inside the chip
-    G4double chipInnerY {6};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
-    G4double chipInnerZ {3};
-
-    G4Box* chipInner = 
-      new G4Box("chipInner",                       //its name
-          0.5 * chipInnerX, 0.5 * chipInnerY, 0.5 * chipInnerZ);   //its size
-    
-    G4LogicalVolume* logicChipInner = 
-      new G4LogicalVolume(chipInner,         //?? not sure think thats its in diodeOuter above
-                          chipInnerMat,      //its material
-                          "chipInner");      //its name
-            
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, 0, 0),      //coordinate
-                      logicChipInner,      //it's logical volume
-                      "chipOuter",         //its name
-                      logicChipOuter,      //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);
-      }
 
+  /*
+  AG creating the diode
+  */
+  G4Material* diodeOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
+  G4double diodeOuterX {40}; //defining x, y, z lengths of the diode
+  G4double diodeOuterY {30};
+  G4double diodeOuterZ {1};
+
+  G4Box* diodeOuter = 
+    new G4Box("diodeOuter",                       //its name
+        0.5 * diodeOuterX, 0.5 * diodeOuterY, 0.5 * diodeOuterZ);   //its size
+  
+  G4LogicalVolume* logicDiodeOuter = 
+    new G4LogicalVolume(diodeOuter,         //its solid ?? presumably means filled by diodeOuter
+                        diodeOuterMat,      //its material
+                        "diodeOuter");      //its name
+        
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, -14.5, 3),      //coordinate
+                    logicDiodeOuter,      //it's logical volume
+                    "diodeOuter",         //its name
+                    logicEnv,             //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);       //overlaps checking
   
 
-    /*
-    AG creating the diode
-    */
-    G4Material* diodeOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
-    G4double diodeOuterX {40}; //defining x, y, z lengths of the diode
-    G4double diodeOuterY {30};
-    G4double diodeOuterZ {1};
-
-    G4Box* diodeOuter = 
-      new G4Box("diodeOuter",                       //its name
-          0.5 * diodeOuterX, 0.5 * diodeOuterY, 0.5 * diodeOuterZ);   //its size
-    
-    G4LogicalVolume* logicDiodeOuter = 
-      new G4LogicalVolume(diodeOuter,         //its solid ?? presumably means filled by diodeOuter
-                          diodeOuterMat,      //its material
-                          "diodeOuter");      //its name
-          
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, -14.5, 3),      //coordinate
-                      logicDiodeOuter,      //it's logical volume
-                      "diodeOuter",         //its name
-                      logicEnv,             //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);       //overlaps checking
-    
-
-    G4Material* diodeInnerMat = nist->FindOrBuildMaterial("G4_Si");  //not sure if this is the name of a real plastic
-    G4double diodeInnerX {29};   //defining x, y, z lengths of the sensor inside the diode
-    G4double diodeInnerY {29};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
-    G4double diodeInnerZ {4e-3};
-
-    G4Box* diodeInner = 
-      new G4Box("diodeInner",                       //its name
-          0.5 * diodeInnerX, 0.5 * diodeInnerY, 0.5 * diodeInnerZ);   //its size
-    
-    G4LogicalVolume* logicDiodeInner = 
-      new G4LogicalVolume(diodeInner,         //?? not sure think thats its in diodeOuter above
-                          diodeInnerMat,      //its material
-                          "diodeInner");      //its name
-            
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, 0, 0),      //coordinate
-                      logicDiodeInner,      //it's logical volume
-                      "diodeOuter",         //its name
-                      logicDiodeOuter,      //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);
-
-
-    /*
-    Transistor
-    */
-    G4Material* transOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
-    G4double transOuterX {9}; //defining x, y, z lengths of the diode
-    G4double transOuterY {4};
-    G4double transOuterZ {9};
-
-    G4Box* transOuter = 
-      new G4Box("transOuter",                       //its name
-          0.5 * transOuterX, 0.5 * transOuterY, 0.5 * transOuterZ);   //its size
-    
-    G4LogicalVolume* logicTransOuter = 
-      new G4LogicalVolume(transOuter,         //its solid ?? presumably means filled by diodeOuter
-                          transOuterMat,      //its material
-                          "transOuter");      //its name
+  G4Material* diodeInnerMat = nist->FindOrBuildMaterial("G4_Si");  //not sure if this is the name of a real plastic
+  G4double diodeInnerX {29};   //defining x, y, z lengths of the sensor inside the diode
+  G4double diodeInnerY {29};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
+  G4double diodeInnerZ {4e-3};
+
+  G4Box* diodeInner = 
+    new G4Box("diodeInner",                       //its name
+        0.5 * diodeInnerX, 0.5 * diodeInnerY, 0.5 * diodeInnerZ);   //its size
+  
+  G4LogicalVolume* logicDiodeInner = 
+    new G4LogicalVolume(diodeInner,         //?? not sure think thats its in diodeOuter above
+                        diodeInnerMat,      //its material
+                        "diodeInner");      //its name
           
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(-5, 37, 5),      //coordinate
-                      logicTransOuter,      //it's logical volume
-                      "transOuter",         //its name
-                      logicEnv,             //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);       //overlaps checking
-
-
-    G4Material* transInnerMat = nist->FindOrBuildMaterial("G4_Al");  //not sure if this is the name of a real plastic
-    G4double transInnerX {8};   //defining x, y, z lengths of the sensor inside the diode
-    G4double transInnerY {3};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
-    G4double transInnerZ {8};
-
-    G4Box* transInner = 
-      new G4Box("transInner",                       //its name
-          0.5 * transInnerX, 0.5 * transInnerY, 0.5 * transInnerZ);   //its size
-    
-    G4LogicalVolume* logicTransInner = 
-      new G4LogicalVolume(transInner,         //?? not sure think thats its in diodeOuter above
-                          transInnerMat,      //its material
-                          "transInner");      //its name
-            
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, 0, 0),      //coordinate
-                      logicTransInner,      //it's logical volume
-                      "transOuter",         //its name
-                      logicTransOuter,      //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);
-
-    /*
-    counter
-    */
-
-    G4Material* counterOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
-    G4double counterOuterX {19}; //defining x, y, z lengths of the external plastic on the counter
-    G4double counterOuterY {8};
-    G4double counterOuterZ {4};
-
-    G4Box* counterOuter = 
-      new G4Box("counterOuter",                       //its name
-          0.5 * counterOuterX, 0.5 * counterOuterY, 0.5 * counterOuterZ);   //its size
-    
-    G4LogicalVolume* logicCounterOuter = 
-      new G4LogicalVolume(counterOuter,         //its solid ?? presumably means filled by diodeOuter
-                          counterOuterMat,      //its material
-                          "counterOuter");      //its name
-
-    
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, 38, 4),      //coordinate
-                      logicCounterOuter,      //it's logical volume
-                      "counterOuter",         //its name
-                      logicEnv,             //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);       //overlaps checking
-
-
-    G4Material* counterInnerMat = nist->FindOrBuildMaterial("G4_Al");  //not sure if this is the name of a real plastic
-    G4double counterInnerX {18};   //defining x, y, z lengths of the inner components of the counter
-    G4double counterInnerY {7};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
-    G4double counterInnerZ {3};
-
-    G4Box* counterInner = 
-      new G4Box("counterInner",                       //its name
-          0.5 * counterInnerX, 0.5 * counterInnerY, 0.5 * counterInnerZ);   //its size
-    
-    G4LogicalVolume* logicCounterInner = 
-      new G4LogicalVolume(counterInner,         //?? not sure think thats its in diodeOuter above
-                          counterInnerMat,      //its material
-                          "counterInner");      //its name
-            
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, 0, 0),      //coordinate
-                      logicCounterInner,      //it's logical volume
-                      "counterOuter",         //its name
-                      logicCounterOuter,      //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, 0, 0),      //coordinate
+                    logicDiodeInner,      //it's logical volume
+                    "diodeOuter",         //its name
+                    logicDiodeOuter,      //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);
 
 
   /*
-  plastic seperator
+  Transistor
   */
-    G4Material* seperatorMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
-    G4double seperatorX {30};   //defining x, y, z lengths of the seperator sheet which all the components arr attatched to
-    G4double seperatorY {96};  
-    G4double seperatorZ {0.5};
-
-    G4Box* seperator = 
-      new G4Box("seperator",                       //its name
-          0.5 * seperatorX, 0.5 * seperatorY, 0.5 * seperatorZ);   //its size
-    
-    G4LogicalVolume* logicSeperator = 
-      new G4LogicalVolume(seperator,         //?? not sure think thats its in diodeOuter above
-                          seperatorMat,      //its material
-                          "seperator");      //its name
-            
-    new G4PVPlacement(0,                    //no rotation
-                      G4ThreeVector(0, 0, 0),      //coordinate
-                      logicSeperator,      //it's logical volume
-                      "seperator",         //its name
-                      logicEnv,      //its mother volume
-                      false,                //no boolean operation
-                      0,                    //copy number? presumably the number of times it appears which will be more than 0     
-                      checkOverlaps);
-
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
-
-    // Set Metal of Diode (inner diode) as scoring volume
-    //
-
-    fScoringVolume.push_back(logicDiodeInner);
+  G4Material* transOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
+  G4double transOuterX {9}; //defining x, y, z lengths of the diode
+  G4double transOuterY {4};
+  G4double transOuterZ {9};
+
+  G4Box* transOuter = 
+    new G4Box("transOuter",                       //its name
+        0.5 * transOuterX, 0.5 * transOuterY, 0.5 * transOuterZ);   //its size
+  
+  G4LogicalVolume* logicTransOuter = 
+    new G4LogicalVolume(transOuter,         //its solid ?? presumably means filled by diodeOuter
+                        transOuterMat,      //its material
+                        "transOuter");      //its name
+        
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(-5, 37, 5),      //coordinate
+                    logicTransOuter,      //it's logical volume
+                    "transOuter",         //its name
+                    logicEnv,             //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);       //overlaps checking
+
+
+  G4Material* transInnerMat = nist->FindOrBuildMaterial("G4_Al");  //not sure if this is the name of a real plastic
+  G4double transInnerX {8};   //defining x, y, z lengths of the sensor inside the diode
+  G4double transInnerY {3};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
+  G4double transInnerZ {8};
+
+  G4Box* transInner = 
+    new G4Box("transInner",                       //its name
+        0.5 * transInnerX, 0.5 * transInnerY, 0.5 * transInnerZ);   //its size
+  
+  G4LogicalVolume* logicTransInner = 
+    new G4LogicalVolume(transInner,         //?? not sure think thats its in diodeOuter above
+                        transInnerMat,      //its material
+                        "transInner");      //its name
+          
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, 0, 0),      //coordinate
+                    logicTransInner,      //it's logical volume
+                    "transOuter",         //its name
+                    logicTransOuter,      //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);
 
-}
-    //
-    //always return the physical World
-    //
+  /*
+  counter
+  */
+
+  G4Material* counterOuterMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
+  G4double counterOuterX {19}; //defining x, y, z lengths of the external plastic on the counter
+  G4double counterOuterY {8};
+  G4double counterOuterZ {4};
+
+  G4Box* counterOuter = 
+    new G4Box("counterOuter",                       //its name
+        0.5 * counterOuterX, 0.5 * counterOuterY, 0.5 * counterOuterZ);   //its size
+  
+  G4LogicalVolume* logicCounterOuter = 
+    new G4LogicalVolume(counterOuter,         //its solid ?? presumably means filled by diodeOuter
+                        counterOuterMat,      //its material
+                        "counterOuter");      //its name
+
+  
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, 38, 4),      //coordinate
+                    logicCounterOuter,      //it's logical volume
+                    "counterOuter",         //its name
+                    logicEnv,             //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);       //overlaps checking
+
+
+  G4Material* counterInnerMat = nist->FindOrBuildMaterial("G4_Al");  //not sure if this is the name of a real plastic
+  G4double counterInnerX {18};   //defining x, y, z lengths of the inner components of the counter
+  G4double counterInnerY {7};  //note these are just an assumptions as we dont know the true size of the silicon inside the diodes
+  G4double counterInnerZ {3};
+
+  G4Box* counterInner = 
+    new G4Box("counterInner",                       //its name
+        0.5 * counterInnerX, 0.5 * counterInnerY, 0.5 * counterInnerZ);   //its size
+  
+  G4LogicalVolume* logicCounterInner = 
+    new G4LogicalVolume(counterInner,         //?? not sure think thats its in diodeOuter above
+                        counterInnerMat,      //its material
+                        "counterInner");      //its name
+          
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, 0, 0),      //coordinate
+                    logicCounterInner,      //it's logical volume
+                    "counterOuter",         //its name
+                    logicCounterOuter,      //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);
+
+
+/*
+plastic seperator
+*/
+  G4Material* seperatorMat = nist->FindOrBuildMaterial("G4_POLYCARBONATE");  //not sure if this is the name of a real plastic
+  G4double seperatorX {30};   //defining x, y, z lengths of the seperator sheet which all the components arr attatched to
+  G4double seperatorY {96};  
+  G4double seperatorZ {0.5};
+
+  G4Box* seperator = 
+    new G4Box("seperator",                       //its name
+        0.5 * seperatorX, 0.5 * seperatorY, 0.5 * seperatorZ);   //its size
+  
+  G4LogicalVolume* logicSeperator = 
+    new G4LogicalVolume(seperator,         //?? not sure think thats its in diodeOuter above
+                        seperatorMat,      //its material
+                        "seperator");      //its name
+          
+  new G4PVPlacement(0,                    //no rotation
+                    G4ThreeVector(0, 0, 0),      //coordinate
+                    logicSeperator,      //it's logical volume
+                    "seperator",         //its name
+                    logicEnv,      //its mother volume
+                    false,                //no boolean operation
+                    0,                    //copy number? presumably the number of times it appears which will be more than 0     
+                    checkOverlaps);
+
+  /////////////////////////////////////////////////////////////////////////////////////////////////////
+
+  // Set Metal of Diode (inner diode) as scoring volume
+  //
+
+  fScoringVolume.push_back(logicDiodeInner);
+
+  //placing the envelope at every pixel location with one parameterised volume, the parameterisation works out the
+  //position of each envelope from its copy number, which is the index of its pixel, so no table of locations is kept
+
+  B1PixelParameterisation* pixelParam =
+    new B1PixelParameterisation(len, env_sizeX, env_sizeY, env_sizeZ);
+  pixelParam->GetExtent(fLatticeLower, fLatticeUpper);
+
+  new G4PVParameterised("Envelope",              //its name
+                        logicEnv,                //its logical volume
+                        logicWorld,              //its mother  volume
+                        kUndefined,              //no single axis, the lattice is 3D
+                        lenCubed,                //number of copies
+                        pixelParam,              //the parameterisation
+                        checkOverlaps);          //overlaps checking
+
+  DefineRegions(logicEnv);
+
+  // only the freshly built geometry goes to the cache
+  cache.Write(physWorld);
+
+  //
+  //always return the physical World
+  //
   return physWorld;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DetectorConstruction::DefineRegions(G4LogicalVolume* logicEnv)
+{
+  // Regions, so the silicon and the passive parts can have their own production cuts. The passive region is
+  // everything in the envelope except the diode silicon, which is a region of its own. The cuts below are the
+  // defaults, they can be changed from a macro with /run/setCutForRegion Silicon (or Passive) <cut> <unit>
+  G4Region* siliconRegion = new G4Region("Silicon");
+  for (G4LogicalVolume* vol: fScoringVolume) {
+    siliconRegion->AddRootLogicalVolume(vol);
+  }
+  G4ProductionCuts* siliconCuts = new G4ProductionCuts();
+  siliconCuts->SetProductionCut(1.*um);
+  siliconRegion->SetProductionCuts(siliconCuts);
+
+  G4Region* passiveRegion = new G4Region("Passive");
+  passiveRegion->AddRootLogicalVolume(logicEnv);
+  G4ProductionCuts* passiveCuts = new G4ProductionCuts();
+  passiveCuts->SetProductionCut(1.*mm);
+  passiveRegion->SetProductionCuts(passiveCuts);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B1DetectorConstruction::ConstructSDandField()
+{
+  // Sensitive detector for the diode silicon, every scoring volume records
+  // its hits into the one hits collection
+
+  G4String diodeSDname = "B1/DiodeSD";
+  B1DiodeSD* diodeSD = new B1DiodeSD(diodeSDname,
+                                     "DiodeHitsCollection");
+  G4SDManager::GetSDMpointer()->AddNewDetector(diodeSD);
+
+  for (G4LogicalVolume* vol: fScoringVolume) {
+    SetSensitiveDetector(vol, diodeSD);
+  }
+}
+
   //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
\ No newline at end of file
@@ -0,0 +1,223 @@
+#ifndef DIGITISATION_HPP
+#define DIGITISATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "TrackRandom.hpp"
+
+/*
+Digitisation of the geometric hits, to turn them into the hits a real detector would read out. A track through a
+sensor leaves a charge drawn from the Landau distribution, which grows with the length of its path in the sensor, and
+the pixel fires if the charge times the pixel's gain reaches the pixel's threshold. Every pixel can also fire from
+noise, on its own in any event.
+
+Charges are in units of the most probable charge of a track crossing a sensor straight through, so a threshold of 0.5
+is half of that. A track with a path r times the thickness leaves
+
+        r * (1 + width * (lambda - lambda mode))
+
+with lambda drawn from the standard Landau distribution, whose mode is at -0.2228, and width the Landau width over the
+most probable charge. The gains and thresholds of the pixels are spread around their nominal values once for the whole
+detector, from their own seed.
+
+The Landau numbers are drawn by inverting its cumulative distribution, from a table of it made once at the start. The
+table comes from the integral for the cumulative distribution of a stable distribution (Nolan 1997), whose integrand
+is never negative, so it needs no special care. Beyond the table the tail is 1 - F(lambda) = 1 / lambda.
+
+Noise hits are found by skipping over the pixels: the number of quiet pixels before the next noisy one is drawn from
+the geometric distribution, so an event costs as much as its noise hits, however many pixels the detector has.
+*/
+
+struct DigitisationSettings
+{
+    double threshold{0.5};          //threshold of the pixels, in most probable charges of a straight track
+    double thresholdSpread{0.05};   //rms of the thresholds over the pixels, as a share of the threshold
+    double gainSpread{0.05};        //rms of the gains over the pixels, around 1
+    double width{0.1};              //Landau width over the most probable charge
+    double noise{1e-5};             //chance of a pixel firing from noise in an event
+};
+
+//hits before and after digitisation
+struct DigitisationStatistics
+{
+    long long events{0};
+    long long geometric{0};     //pixels crossed by a track
+    long long fired{0};         //pixels crossed by a track that reached their threshold
+    long long noise{0};         //pixels fired by noise alone
+
+    void merge(const DigitisationStatistics& other)
+    {
+        events += other.events;
+        geometric += other.geometric;
+        fired += other.fired;
+        noise += other.noise;
+    }
+
+    double efficiency() const
+    {
+        return geometric > 0 ? static_cast<double>(fired) / geometric : 0;
+    }
+
+    double noisePerEvent() const
+    {
+        return events > 0 ? static_cast<double>(noise) / events : 0;
+    }
+};
+
+class Digitiser
+{
+public:
+    /*
+    inputs:
+            pixelCount: int, the number of pixels, with ids from 0 to pixelCount - 1
+            settings: DigitisationSettings
+            seed: the seed of the spread of the gains and thresholds
+    */
+
+    Digitiser(int pixelCount, const DigitisationSettings& settings, std::uint64_t seed)
+        : fSettings{settings}, fPixelCount{pixelCount}
+    {
+        SplitMix64 gen{mix64(seed)};
+        std::normal_distribution<double> spread(0, 1);
+        fGain.resize(pixelCount);
+        fThreshold.resize(pixelCount);
+        for(int pixel{0}; pixel < pixelCount; ++pixel)
+        {
+            fGain[pixel] = std::max(0.0, 1 + settings.gainSpread * spread(gen));
+            fThreshold[pixel] = std::max(0.0, settings.threshold * (1 + settings.thresholdSpread * spread(gen)));
+        }
+        fillLandauTable();
+    }
+
+    //draws from the standard Landau distribution
+    template <typename Generator>
+    double landau(Generator& gen) const
+    {
+        double u{std::uniform_real_distribution<double>(0, 1)(gen)};
+        double position{u * tableSize};
+        int bin{static_cast<int>(position)};
+        if(bin >= tableSize - 1) {return 1 / (1 - u);}
+        double fraction{position - bin};
+        return fLandau[bin] + fraction * (fLandau[bin + 1] - fLandau[bin]);
+    }
+
+    //draws the charge of a track whose path in the sensor is pathRatio times its thickness
+    template <typename Generator>
+    double charge(double pathRatio, Generator& gen) const
+    {
+        return std::max(0.0, pathRatio * (1 + fSettings.width * (landau(gen) - landauMode)));
+    }
+
+    /*
+    This function digitises the hits of an event, dropping the pixels that stay below threshold and adding the noise hits
+
+    inputs:
+            hits: the ids of the hit pixels, each once, called by reference and left with the pixels that fired
+            owners: for each hit, a bit for each track through the pixel, called by reference and kept in step with the
+                    hits, noise hits have no bits
+            pathRatios: for each track, its path in a sensor over the sensor's thickness
+            gen: the random number generator of the event
+            stats: DigitisationStatistics, the event is added to these
+    */
+
+    template <typename Generator>
+    void digitise(std::vector<int>& hits, std::vector<std::uint64_t>& owners, const std::vector<double>& pathRatios, Generator& gen,
+                  DigitisationStatistics& stats) const
+    {
+        ++stats.events;
+        stats.geometric += static_cast<long long>(hits.size());
+        std::size_t kept{0};
+        for(std::size_t h{0}; h < hits.size(); ++h)
+        {
+            double deposit{0};
+            for(std::size_t k{0}; k < pathRatios.size(); ++k)
+            {
+                if((owners[h] >> k) & 1) {deposit += charge(pathRatios[k], gen);}
+            }
+            if(fGain[hits[h]] * deposit < fThreshold[hits[h]]) {continue;}
+            hits[kept] = hits[h];
+            owners[kept] = owners[h];
+            ++kept;
+        }
+        hits.resize(kept);
+        owners.resize(kept);
+        stats.fired += static_cast<long long>(kept);
+
+        if(fSettings.noise <= 0) {return;}
+        //the number of quiet pixels before each noisy one
+        std::uniform_real_distribution<double> unif(0, 1);
+        double logQuiet{std::log1p(-std::min(fSettings.noise, 1 - 1e-12))};
+        for(double pixel{std::floor(std::log(1 - unif(gen)) / logQuiet)}; pixel < fPixelCount;
+            pixel += 1 + std::floor(std::log(1 - unif(gen)) / logQuiet))
+        {
+            int noisy{static_cast<int>(pixel)};
+            if(std::find(hits.begin(), hits.begin() + kept, noisy) != hits.begin() + kept) {continue;}
+            hits.push_back(noisy);
+            owners.push_back(0);
+            ++stats.noise;
+        }
+    }
+
+private:
+    static constexpr int tableSize{4096};
+    static constexpr double landauMode{-0.22278};
+
+    /*
+    This function finds the cumulative distribution of the standard Landau distribution, with
+    V(theta) = (2 / pi) (pi / 2 + theta) / cos(theta) exp((pi / 2 + theta) tan(theta)) it is
+
+            F(lambda) = (1 / pi) * integral from -pi / 2 to pi / 2 of exp(-(pi / 2) exp(-lambda) V(theta)) dtheta
+    */
+
+    static double landauCumulative(double lambda)
+    {
+        const double pi{3.14159265358979323846};
+        const int steps{256};
+        double total{0};
+        for(int i{0}; i < steps; ++i)
+        {
+            double theta{-pi / 2 + (i + 0.5) * pi / steps};
+            double angle{pi / 2 + theta};
+            //the log of (pi / 2) exp(-lambda) V(theta), so that it cannot overflow
+            double logV{std::log(angle / std::cos(theta)) + angle * std::tan(theta) - lambda};
+            if(logV < 700) {total += std::exp(-std::exp(logV));}
+        }
+        return total / steps;
+    }
+
+    //the table of lambda at the cumulative probabilities i / tableSize, from the cumulative distribution on a grid of
+    //lambda that is fine near the peak and grows geometrically in the tail
+    void fillLandauTable()
+    {
+        fLandau.assign(tableSize, 0);
+        double lambda{-5};
+        double previousLambda{lambda};
+        double previous{landauCumulative(lambda)};
+        double current{previous};
+        fLandau[0] = lambda;
+        for(int i{1}; i < tableSize; ++i)
+        {
+            double wanted{static_cast<double>(i) / tableSize};
+            while(current < wanted)
+            {
+                previousLambda = lambda;
+                previous = current;
+                lambda = lambda < 30 ? lambda + 0.01 : lambda * 1.01;
+                current = landauCumulative(lambda);
+            }
+            fLandau[i] = previousLambda + (lambda - previousLambda) * (wanted - previous) / std::max(current - previous, 1e-300);
+        }
+    }
+
+    DigitisationSettings fSettings{};
+    int fPixelCount{0};
+    std::vector<double> fGain{};
+    std::vector<double> fThreshold{};
+    std::vector<double> fLandau{};
+};
+
+#endif
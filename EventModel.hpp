@@ -0,0 +1,181 @@
+#ifndef EVENT_MODEL_HPP
+#define EVENT_MODEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TrackGenerator.hpp"
+
+/*
+Events of several coincident tracks, as from a cosmic ray shower or a beam spill. The number of tracks in an event
+comes from one of three models:
+
+        fixed:      the same number of tracks in every event, each drawn on its own from the track source
+        poisson:    a Poisson number of tracks with the given mean, each drawn on its own, for uncorrelated pile up
+        bundle:     a shower core drawn from the track source plus a Poisson number of companions, so the mean number
+                    of tracks is the given mean. The companions are near parallel to the core, their directions are
+                    spread by a small angle, and they cross the plane through the core's entry point perpendicular to
+                    it at a uniform point within a radius of the core
+
+An event has at most maxEventTracks tracks, so the tracks that made a hit fit in the bits of a std::uint64_t, more are
+dropped. All of the random numbers of an event come from the generator of its event number.
+*/
+
+//the most tracks in an event
+const int maxEventTracks{64};
+
+enum class Multiplicity {fixed, poisson, bundle};
+
+inline std::string multiplicityName(Multiplicity multiplicity)
+{
+    switch(multiplicity)
+    {
+        case Multiplicity::poisson: return "poisson";
+        case Multiplicity::bundle: return "bundle";
+        default: return "fixed";
+    }
+}
+
+//returns false if the name is not one of the multiplicity models
+inline bool parseMultiplicity(const std::string& name, Multiplicity& multiplicity)
+{
+    for(Multiplicity candidate : {Multiplicity::fixed, Multiplicity::poisson, Multiplicity::bundle})
+    {
+        if(name == multiplicityName(candidate))
+        {
+            multiplicity = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct EventSettings
+{
+    Multiplicity multiplicity{Multiplicity::fixed};
+    double tracks{1};       //number of tracks for fixed, mean number for poisson and bundle
+    double spread{0.01};    //rms angle of the companions of a bundle to its core, radians
+    double radius{200};     //the companions of a bundle cross within this distance of the core
+};
+
+/*
+This function makes the tracks of an event
+
+inputs:
+        settings: EventSettings, how many tracks and how they are related
+        source: TrackSource, where the tracks come from, bundles need isotropic or cosmic tracks
+        start: Box, the region start points of uniform tracks are drawn from
+        detector: Box, a box around all of the sensors
+        gen: the random number generator of the event
+        tracks: an empty vector called by reference, filled with the tracks of the event
+*/
+
+template <typename Generator>
+void generateEvent(const EventSettings& settings, TrackSource source, const Box& start, const Box& detector, Generator& gen,
+                   std::vector<Track>& tracks)
+{
+    tracks.clear();
+    int count{static_cast<int>(std::lround(settings.tracks))};
+    if(settings.multiplicity == Multiplicity::poisson) {count = std::poisson_distribution<int>(settings.tracks)(gen);}
+    else if(settings.multiplicity == Multiplicity::bundle && settings.tracks > 1)
+    {
+        count = 1 + std::poisson_distribution<int>(settings.tracks - 1)(gen);
+    }
+    count = std::min(count, maxEventTracks);
+
+    if(settings.multiplicity != Multiplicity::bundle)
+    {
+        for(int k{0}; k < count; ++k) {tracks.push_back(generateTrack(source, start, detector, gen));}
+        return;
+    }
+
+    const double pi{3.14159265358979323846};
+    Track core{generateTrack(source, start, detector, gen)};
+    tracks.push_back(core);
+    std::array<double, 3> direction{core.a, core.b, core.c};
+    //two unit vectors across the core, the first one horizontal unless the core is vertical
+    std::array<double, 3> across{-direction[2], 0, direction[0]};
+    double length{std::sqrt(across[0] * across[0] + across[2] * across[2])};
+    if(length < 1e-12) {across = {1, 0, 0};}
+    else {for(double& component : across) {component /= length;}}
+    std::array<double, 3> other{direction[1] * across[2] - direction[2] * across[1],
+                                direction[2] * across[0] - direction[0] * across[2],
+                                direction[0] * across[1] - direction[1] * across[0]};
+
+    std::normal_distribution<double> angle(0, settings.spread);
+    std::uniform_real_distribution<double> unif(0, 1);
+    for(int k{1}; k < count; ++k)
+    {
+        double tiltAcross{angle(gen)};
+        double tiltOther{angle(gen)};
+        double distance{settings.radius * std::sqrt(unif(gen))};
+        double phi{2 * pi * unif(gen)};
+        Track companion{core};
+        companion.a = direction[0] + tiltAcross * across[0] + tiltOther * other[0];
+        companion.b = direction[1] + tiltAcross * across[1] + tiltOther * other[1];
+        companion.c = direction[2] + tiltAcross * across[2] + tiltOther * other[2];
+        companion.x1 += distance * (std::cos(phi) * across[0] + std::sin(phi) * other[0]);
+        companion.y1 += distance * (std::cos(phi) * across[1] + std::sin(phi) * other[1]);
+        companion.z1 += distance * (std::cos(phi) * across[2] + std::sin(phi) * other[2]);
+        tracks.push_back(companion);
+    }
+}
+
+/*
+Occupancy and ambiguity of the events. A pixel hit by several tracks of an event fires once, so the hits of the event
+are fewer than the hits of its tracks, and a shared hit cannot be given to one track
+*/
+
+struct PileUpStatistics
+{
+    long long events{0};
+    long long tracks{0};
+    long long trackHits{0};     //hits of the tracks, counting a pixel once for each track through it
+    long long hits{0};          //hit pixels of the events
+    long long shared{0};        //hit pixels made by 2 or more tracks
+
+    /*
+    This function adds an event
+
+    inputs:
+            owners: for each hit pixel of the event, a bit for each track that made it
+            hitsOfTracks: the number of hits of each track
+    */
+
+    void add(const std::vector<std::uint64_t>& owners, const std::vector<int>& hitsOfTracks)
+    {
+        ++events;
+        tracks += static_cast<long long>(hitsOfTracks.size());
+        for(int count : hitsOfTracks) {trackHits += count;}
+        hits += static_cast<long long>(owners.size());
+        for(std::uint64_t owner : owners) {shared += (owner & (owner - 1)) != 0;}
+    }
+
+    void merge(const PileUpStatistics& other)
+    {
+        events += other.events;
+        tracks += other.tracks;
+        trackHits += other.trackHits;
+        hits += other.hits;
+        shared += other.shared;
+    }
+
+    //share of the pixels hit in an event
+    double occupancy(int pixelCount) const
+    {
+        return events > 0 ? static_cast<double>(hits) / (static_cast<double>(events) * pixelCount) : 0;
+    }
+
+    //share of the hit pixels made by more than one track
+    double sharedFraction() const
+    {
+        return hits > 0 ? static_cast<double>(shared) / hits : 0;
+    }
+};
+
+#endif
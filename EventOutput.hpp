@@ -0,0 +1,407 @@
+#ifndef EVENT_OUTPUT_HPP
+#define EVENT_OUTPUT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TrackGenerator.hpp"
+
+/*
+Per event output of the standalone simulations, so that an analysis can go over the same events again without
+simulating them. An event is one track: its number in the run, the track and its weight, the pixel ids of the sensors it
+hit and the length of its path through each of them.
+
+The file is split into chunks of events and each chunk is stored column by column, all x1 values, then all y1 values
+and so on, which packs well and lets a reader skip the columns it does not need:
+
+        header:     magic "HITEVNT1", flags (1 if there are path lengths)
+        chunks:     first event number, number of events
+                    x1, y1, z1, a, b, c, weight, each a column of doubles
+                    number of bytes of hit counts, the hit counts as varints
+                    number of bytes of pixel ids, the pixel ids of each event in increasing order as varints of the
+                    difference from the previous id of the event (the first from 0)
+                    the path lengths as floats, in the same order as the pixel ids
+        footer:     number of chunks, then for each chunk its first event number, number of events, offset and size
+                    total number of events, offset of the footer, magic "HITEVEND"
+
+All numbers are little endian. The reader maps the file into memory (POSIX mmap) and uses the footer to go straight to
+the chunks holding any range of events.
+*/
+
+const char eventMagic[8]{'H', 'I', 'T', 'E', 'V', 'N', 'T', '1'};
+const char eventEndMagic[8]{'H', 'I', 'T', 'E', 'V', 'E', 'N', 'D'};
+
+struct Event
+{
+    long long number{0};                //number of the track in the run
+    Track track{};
+    std::vector<int> pixels{};          //ids of the hit sensors, x + len * y + len * len * z
+    std::vector<float> pathLengths{};   //length of the track inside each hit sensor, empty if not stored
+};
+
+inline void appendBytes(std::vector<unsigned char>& buffer, const void* data, std::size_t size)
+{
+    const unsigned char* bytes{static_cast<const unsigned char*>(data)};
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+inline void appendVarint(std::vector<unsigned char>& buffer, std::uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        buffer.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<unsigned char>(value));
+}
+
+//reads a varint that must end before end, returns false if it runs past end or is too long for 64 bits
+inline bool takeVarint(const unsigned char*& position, const unsigned char* end, std::uint64_t& value)
+{
+    value = 0;
+    for(int shift{0}; shift < 64 && position < end; shift += 7)
+    {
+        unsigned char byte{*position++};
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if(byte < 0x80) {return true;}
+    }
+    return false;
+}
+
+template <typename T>
+T takeValue(const unsigned char*& position)
+{
+    T value{};
+    std::memcpy(&value, position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+/*
+Writes events to a file. Events have to be added in order of their number, with no gaps, and close must be called (or
+the writer destroyed) to write the last chunk and the footer
+*/
+
+class EventWriter
+{
+public:
+    static constexpr std::size_t chunkEvents{65536};
+
+    bool open(const std::string& path, bool pathLengths)
+    {
+        fFile.open(path, std::ios::binary | std::ios::trunc);
+        fPathLengths = pathLengths;
+        fIndex.clear();
+        fTotal = 0;
+        fFile.write(eventMagic, 8);
+        std::uint64_t flags{pathLengths ? 1ULL : 0ULL};
+        fFile.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+        return static_cast<bool>(fFile);
+    }
+
+    bool isOpen() const
+    {
+        return fFile.is_open();
+    }
+
+    /*
+    This function adds an event
+
+    inputs:
+            number: the number of the track in the run
+            track: the track
+            pixels: the ids of the hit sensors, in any order
+            pathLength: the length of the track inside each sensor, ignored if the file has no path lengths
+    */
+
+    void add(long long number, const Track& track, const std::vector<int>& pixels, float pathLength)
+    {
+        if(fCount == 0) {fFirst = number;}
+        double values[7]{track.x1, track.y1, track.z1, track.a, track.b, track.c, track.weight};
+        for(int i{0}; i < 7; ++i) {fColumns[i].push_back(values[i]);}
+
+        fSorted.assign(pixels.begin(), pixels.end());
+        std::sort(fSorted.begin(), fSorted.end());
+        appendVarint(fHitCounts, fSorted.size());
+        int previous{0};
+        for(int pixel : fSorted)
+        {
+            appendVarint(fPixelIds, static_cast<std::uint64_t>(pixel - previous));
+            previous = pixel;
+            if(fPathLengths) {fLengths.push_back(pathLength);}
+        }
+
+        if(++fCount == chunkEvents) {writeChunk();}
+    }
+
+    bool close()
+    {
+        if(!fFile.is_open()) {return false;}
+        writeChunk();
+        std::uint64_t footer{static_cast<std::uint64_t>(fFile.tellp())};
+        std::vector<unsigned char> buffer{};
+        std::uint64_t chunks{fIndex.size()};
+        appendBytes(buffer, &chunks, sizeof(chunks));
+        for(const std::array<std::uint64_t, 4>& entry : fIndex) {appendBytes(buffer, entry.data(), sizeof(entry));}
+        appendBytes(buffer, &fTotal, sizeof(fTotal));
+        appendBytes(buffer, &footer, sizeof(footer));
+        appendBytes(buffer, eventEndMagic, 8);
+        fFile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        bool good{static_cast<bool>(fFile)};
+        fFile.close();
+        return good;
+    }
+
+    ~EventWriter()
+    {
+        close();
+    }
+
+private:
+    void writeChunk()
+    {
+        if(fCount == 0) {return;}
+        std::vector<unsigned char> buffer{};
+        std::uint64_t first{static_cast<std::uint64_t>(fFirst)};
+        std::uint64_t count{fCount};
+        appendBytes(buffer, &first, sizeof(first));
+        appendBytes(buffer, &count, sizeof(count));
+        for(std::vector<double>& column : fColumns)
+        {
+            appendBytes(buffer, column.data(), column.size() * sizeof(double));
+            column.clear();
+        }
+        std::uint64_t bytes{fHitCounts.size()};
+        appendBytes(buffer, &bytes, sizeof(bytes));
+        appendBytes(buffer, fHitCounts.data(), fHitCounts.size());
+        bytes = fPixelIds.size();
+        appendBytes(buffer, &bytes, sizeof(bytes));
+        appendBytes(buffer, fPixelIds.data(), fPixelIds.size());
+        appendBytes(buffer, fLengths.data(), fLengths.size() * sizeof(float));
+
+        std::uint64_t offset{static_cast<std::uint64_t>(fFile.tellp())};
+        fFile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        fIndex.push_back({first, count, offset, buffer.size()});
+        fTotal += count;
+
+        fHitCounts.clear();
+        fPixelIds.clear();
+        fLengths.clear();
+        fCount = 0;
+    }
+
+    std::ofstream fFile{};
+    bool fPathLengths{false};
+    long long fFirst{0};
+    std::size_t fCount{0};
+    std::uint64_t fTotal{0};
+    std::vector<double> fColumns[7]{};
+    std::vector<unsigned char> fHitCounts{};
+    std::vector<unsigned char> fPixelIds{};
+    std::vector<float> fLengths{};
+    std::vector<int> fSorted{};
+    std::vector<std::array<std::uint64_t, 4>> fIndex{};    //first event, number of events, offset, size of each chunk
+};
+
+/*
+Reads events back from a file written by EventWriter, mapping it into memory so that any range of events can be read
+without going through the rest of the file
+*/
+
+class EventReader
+{
+public:
+    bool open(const std::string& path)
+    {
+        close();
+        int descriptor{::open(path.c_str(), O_RDONLY)};
+        if(descriptor < 0) {return false;}
+        struct stat status{};
+        if(fstat(descriptor, &status) != 0 || status.st_size < 48)
+        {
+            ::close(descriptor);
+            return false;
+        }
+        fSize = static_cast<std::size_t>(status.st_size);
+        void* mapped{mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+        ::close(descriptor);
+        if(mapped == MAP_FAILED) {return false;}
+        fData = static_cast<const unsigned char*>(mapped);
+
+        //the header, then the footer from the end of the file
+        const unsigned char* end{fData + fSize - 8};
+        if(std::memcmp(fData, eventMagic, 8) != 0 || std::memcmp(end, eventEndMagic, 8) != 0)
+        {
+            close();
+            return false;
+        }
+        const unsigned char* position{fData + 8};
+        fPathLengths = takeValue<std::uint64_t>(position) & 1;
+        position = end - 16;
+        fTotal = takeValue<std::uint64_t>(position);
+        std::uint64_t footer{takeValue<std::uint64_t>(position)};
+        //the footer has to be inside the file before its count is read, and the count small enough that chunks * 32
+        //cannot wrap, so a truncated or corrupt file is turned down rather than read out of bounds
+        if(footer < 16 || footer > fSize - 8 - 24)
+        {
+            close();
+            return false;
+        }
+        position = fData + footer;
+        std::uint64_t chunks{takeValue<std::uint64_t>(position)};
+        if(chunks > (fSize - footer) / 32 || footer + 8 + chunks * 32 + 24 != fSize)
+        {
+            close();
+            return false;
+        }
+        fIndex.resize(chunks);
+        for(std::array<std::uint64_t, 4>& entry : fIndex)
+        {
+            for(std::uint64_t& field : entry) {field = takeValue<std::uint64_t>(position);}
+            //every chunk lies between the header and the footer
+            if(entry[2] < 16 || entry[2] > footer || entry[3] > footer - entry[2])
+            {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if(fData != nullptr) {munmap(const_cast<unsigned char*>(fData), fSize);}
+        fData = nullptr;
+        fSize = 0;
+        fIndex.clear();
+        fTotal = 0;
+    }
+
+    ~EventReader()
+    {
+        close();
+    }
+
+    //number of events in the file
+    long long eventCount() const
+    {
+        return static_cast<long long>(fTotal);
+    }
+
+    //number of the first and one past the last event in the file
+    long long firstEvent() const
+    {
+        return fIndex.empty() ? 0 : static_cast<long long>(fIndex.front()[0]);
+    }
+
+    long long lastEvent() const
+    {
+        return fIndex.empty() ? 0 : static_cast<long long>(fIndex.back()[0] + fIndex.back()[1]);
+    }
+
+    bool hasPathLengths() const
+    {
+        return fPathLengths;
+    }
+
+    /*
+    This function calls a function on every event with a number from first to last - 1 that is in the file, in order
+
+    inputs:
+            first, last: the range of event numbers
+            function: called as function(const Event&)
+
+    outputs:
+            bool, false if a chunk is corrupt, it stops there and the events before it have been called
+    */
+
+    template <typename Function>
+    bool forEachEvent(long long first, long long last, Function function) const
+    {
+        //the first chunk that ends after the first event wanted
+        auto chunk{std::partition_point(fIndex.begin(), fIndex.end(), [first](const std::array<std::uint64_t, 4>& entry)
+                                        {return static_cast<long long>(entry[0] + entry[1]) <= first;})};
+        Event event{};
+        for(; chunk != fIndex.end() && static_cast<long long>((*chunk)[0]) < last; ++chunk)
+        {
+            //every length read from the chunk is checked against what is left of it, so a corrupt chunk is turned down
+            //rather than read past its end
+            if((*chunk)[3] < 16) {return false;}
+            const unsigned char* position{fData + (*chunk)[2]};
+            const unsigned char* chunkEnd{position + (*chunk)[3]};
+            long long chunkFirst{static_cast<long long>(takeValue<std::uint64_t>(position))};
+            std::uint64_t count{takeValue<std::uint64_t>(position)};
+            if(count > static_cast<std::uint64_t>(chunkEnd - position) / (7 * sizeof(double))) {return false;}
+            const unsigned char* columns{position};
+            position += 7 * count * sizeof(double);
+            if(chunkEnd - position < 8) {return false;}
+            std::uint64_t bytes{takeValue<std::uint64_t>(position)};
+            if(bytes > static_cast<std::uint64_t>(chunkEnd - position) || chunkEnd - position - bytes < 8) {return false;}
+            const unsigned char* hitCounts{position};
+            const unsigned char* hitCountsEnd{position + bytes};
+            position += bytes;
+            bytes = takeValue<std::uint64_t>(position);
+            if(bytes > static_cast<std::uint64_t>(chunkEnd - position)) {return false;}
+            const unsigned char* pixelIds{position};
+            const unsigned char* pixelIdsEnd{position + bytes};
+            const unsigned char* lengths{pixelIdsEnd};
+
+            for(std::size_t i{0}; i < count; ++i)
+            {
+                std::uint64_t hits{0};
+                //each pixel id takes at least one byte
+                if(!takeVarint(hitCounts, hitCountsEnd, hits) || hits > static_cast<std::uint64_t>(pixelIdsEnd - pixelIds))
+                {
+                    return false;
+                }
+                event.number = chunkFirst + static_cast<long long>(i);
+                event.pixels.resize(hits);
+                int previous{0};
+                for(int& pixel : event.pixels)
+                {
+                    std::uint64_t step{0};
+                    if(!takeVarint(pixelIds, pixelIdsEnd, step)) {return false;}
+                    pixel = previous + static_cast<int>(step);
+                    previous = pixel;
+                }
+                event.pathLengths.resize(fPathLengths ? hits : 0);
+                if(fPathLengths)
+                {
+                    if(hits > static_cast<std::uint64_t>(chunkEnd - lengths) / sizeof(float)) {return false;}
+                    std::memcpy(event.pathLengths.data(), lengths, hits * sizeof(float));
+                    lengths += hits * sizeof(float);
+                }
+                if(event.number < first || event.number >= last) {continue;}
+
+                double values[7]{};
+                for(int column{0}; column < 7; ++column)
+                {
+                    std::memcpy(&values[column], columns + (column * count + i) * sizeof(double), sizeof(double));
+                }
+                event.track = {values[0], values[1], values[2], values[3], values[4], values[5], values[6]};
+                function(static_cast<const Event&>(event));
+            }
+        }
+        return true;
+    }
+
+private:
+    const unsigned char* fData{nullptr};
+    std::size_t fSize{0};
+    bool fPathLengths{false};
+    std::uint64_t fTotal{0};
+    std::vector<std::array<std::uint64_t, 4>> fIndex{};
+};
+
+#endif
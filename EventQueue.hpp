@@ -0,0 +1,214 @@
+#ifndef EVENT_QUEUE_HPP
+#define EVENT_QUEUE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EventOutput.hpp"
+
+/*
+Event output off the simulation threads. Each simulation thread puts fixed size event records into its own lock free
+single producer, single consumer ring, and one writer thread takes them out and encodes them with an EventWriter, which
+turns them into large sequential writes a chunk at a time. The simulation threads never touch the file.
+
+A full ring makes its simulation thread wait for the writer, and an empty ring makes the writer wait for the simulation.
+Both are counted rather than hidden, so a run can report whether it was held up by its output.
+*/
+
+/*
+A fixed size ring of items between one producer thread and one consumer thread. The head is only written by the
+producer and the tail only by the consumer, each on its own cache line, and each side keeps a copy of the other side's
+index so it only has to read the shared one when the ring looks full or empty
+*/
+
+template <typename T>
+class SpscRing
+{
+public:
+    //the capacity is rounded up to a power of 2
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t size{1};
+        while(size < capacity) {size *= 2;}
+        fSlots.resize(size);
+        fMask = size - 1;
+    }
+
+    bool tryPush(const T& item)
+    {
+        std::size_t head{fHead.load(std::memory_order_relaxed)};
+        if(head - fTailCopy == fSlots.size())
+        {
+            fTailCopy = fTail.load(std::memory_order_acquire);
+            if(head - fTailCopy == fSlots.size()) {return false;}
+        }
+        fSlots[head & fMask] = item;
+        fHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item)
+    {
+        std::size_t tail{fTail.load(std::memory_order_relaxed)};
+        if(tail == fHeadCopy)
+        {
+            fHeadCopy = fHead.load(std::memory_order_acquire);
+            if(tail == fHeadCopy) {return false;}
+        }
+        item = fSlots[tail & fMask];
+        fTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> fSlots{};
+    std::size_t fMask{0};
+    alignas(64) std::atomic<std::size_t> fHead{0};     //next slot to fill, written by the producer
+    alignas(64) std::size_t fTailCopy{0};               //the producer's copy of the tail
+    alignas(64) std::atomic<std::size_t> fTail{0};     //next slot to empty, written by the consumer
+    alignas(64) std::size_t fHeadCopy{0};               //the consumer's copy of the head
+};
+
+//the most hit pixels a record holds, a straight track hits at most one sensor on each of the 2 * len planes
+const int maxRecordHits{64};
+
+struct EventRecord
+{
+    long long number{0};
+    Track track{};
+    float pathLength{0};
+    int hits{0};
+    std::array<int, maxRecordHits> pixels{};
+};
+
+/*
+Writes the events of a run from several simulation threads. The tracks first ... last - 1 are simulated in blocks of
+blockSize tracks, block k by thread k % producers, and the writer takes the blocks from the threads' rings in turn, so
+the events reach the file in order. Every track in the range must be pushed, by the thread that owns its block
+*/
+
+class AsyncEventWriter
+{
+public:
+    bool open(const std::string& path, bool pathLengths, int producers, long long first, long long last, long long blockSize)
+    {
+        if(!fWriter.open(path, pathLengths)) {return false;}
+        fRings.clear();
+        //a ring holds a whole block, so a thread can simulate its block while the writer is still on another thread's
+        //block, rather than stopping once its ring is full and running one thread at a time
+        std::size_t capacity{static_cast<std::size_t>(std::max(1LL, blockSize))};
+        for(int i{0}; i < producers; ++i) {fRings.push_back(std::make_unique<SpscRing<EventRecord>>(capacity));}
+        fProducerWaits.assign(producers, WaitCount{});
+        fThread = std::thread(&AsyncEventWriter::drain, this, first, last, blockSize);
+        return true;
+    }
+
+    bool isOpen() const
+    {
+        return fWriter.isOpen();
+    }
+
+    /*
+    This function hands an event to the writer, waiting if the thread's ring is full
+
+    inputs:
+            producer: the number of the simulation thread
+            number: the number of the track in the run
+            track: the track
+            pixels: the ids of the hit sensors
+            pathLength: the length of the track inside each sensor
+    */
+
+    void push(int producer, long long number, const Track& track, const std::vector<int>& pixels, float pathLength)
+    {
+        EventRecord record{};
+        record.number = number;
+        record.track = track;
+        record.pathLength = pathLength;
+        record.hits = static_cast<int>(pixels.size());
+        std::copy_n(pixels.begin(), std::min<std::size_t>(pixels.size(), maxRecordHits), record.pixels.begin());
+
+        SpscRing<EventRecord>& ring{*fRings[producer]};
+        if(ring.tryPush(record)) {return;}
+        ++fProducerWaits[producer].count;
+        while(!ring.tryPush(record)) {std::this_thread::yield();}
+    }
+
+    //waits for the writer to finish the events and closes the file, returns false if the file could not be written
+    bool close()
+    {
+        if(fThread.joinable()) {fThread.join();}
+        return fWriter.close() && fInOrder;
+    }
+
+    ~AsyncEventWriter()
+    {
+        close();
+    }
+
+    //number of times a simulation thread found its ring full and had to wait for the writer
+    long long producerWaits() const
+    {
+        long long waits{0};
+        for(const WaitCount& producer : fProducerWaits) {waits += producer.count;}
+        return waits;
+    }
+
+    //number of times the writer found the ring it needed empty and had to wait for the simulation
+    long long writerWaits() const
+    {
+        return fWriterWaits;
+    }
+
+    //number of events with more hits than a record holds, only the first maxRecordHits of them were written
+    long long truncated() const
+    {
+        return fTruncated;
+    }
+
+private:
+    //a producer's wait count on a cache line of its own, so the producers do not share a line as they count
+    struct alignas(64) WaitCount
+    {
+        long long count{0};
+    };
+
+    void drain(long long first, long long last, long long blockSize)
+    {
+        std::vector<int> pixels{};
+        EventRecord record{};
+        long long producers{static_cast<long long>(fRings.size())};
+        for(long long block{0}; first + block * blockSize < last; ++block)
+        {
+            SpscRing<EventRecord>& ring{*fRings[block % producers]};
+            long long end{std::min(last, first + (block + 1) * blockSize)};
+            for(long long number{first + block * blockSize}; number < end; ++number)
+            {
+                if(!ring.tryPop(record))
+                {
+                    ++fWriterWaits;
+                    while(!ring.tryPop(record)) {std::this_thread::yield();}
+                }
+                if(record.number != number) {fInOrder = false;}
+                if(record.hits > maxRecordHits) {++fTruncated;}
+                pixels.assign(record.pixels.begin(), record.pixels.begin() + std::min(record.hits, maxRecordHits));
+                fWriter.add(record.number, record.track, pixels, record.pathLength);
+            }
+        }
+    }
+
+    EventWriter fWriter{};
+    std::vector<std::unique_ptr<SpscRing<EventRecord>>> fRings{};
+    std::vector<WaitCount> fProducerWaits{};    //only written by the producer it belongs to, read after the run
+    long long fWriterWaits{0};
+    long long fTruncated{0};
+    bool fInOrder{true};
+    std::thread fThread{};
+};
+
+#endif
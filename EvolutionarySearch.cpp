@@ -0,0 +1,411 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+/*
+Evolutionary search over cuboid detector layouts, including the discrete choices that LayoutOptimiser.cpp cannot
+handle: the number of layers (len), the offset pattern of the odd layers and the diode shape (the rectangles of the
+Finalised simulations or the circles/cylinders of the initial simulations).
+
+Every layout is scored on the same fixed bank of tracks, so differences between layouts are not hidden under
+sampling noise, and each generation is evaluated in parallel on all cores. Evaluated genomes are cached so the
+survivors of a generation are never simulated twice. The result is the Pareto front of hits per track against the
+number of sensors, over every layout that was evaluated.
+
+The detector is the lattice of Finalised3DCuboidSImulation.cpp: pixel (x, y, z) has a thin sensor on the plane
+y = (y + offsetY) * pixelHeight centred on ((x + offsetX) * pixelWidth, z * pixelDepth), where the offsets are zero on
+even z layers and set by the offset pattern on odd ones. Tracks start in the middle 80% of the detector with a
+direction uniform in a cube, as in the simulation.
+
+usage: EvolutionarySearch [generations] [population] [tracks]
+*/
+
+//half pixel shifts of the odd layers in x and y
+const std::array<std::array<double, 2>, 4> offsetPatterns{{{0, 0}, {0.5, 0.5}, {0.5, 0}, {0, 0.5}}};
+const std::array<std::string, 4> offsetNames{"none", "xy", "x", "y"};
+const std::array<std::string, 2> shapeNames{"rectangle", "circle"};
+
+const double sensorPitch{0.236};
+const double sensorHeight{6e-3};
+
+//pixel sizes are kept on a 0.5 grid so that equal layouts have equal keys in the cache
+const double sizeStep{0.5};
+
+struct Genome
+{
+    double pixelWidth;
+    double pixelHeight;
+    double pixelDepth;
+    int sqrtSensorNo;
+    int len;            //always even, as createCoords fills layers in pairs
+    int offset;         //index into offsetPatterns
+    int shape;          //0 for rectangles, 1 for circles
+
+    auto key() const {return std::make_tuple(pixelWidth, pixelHeight, pixelDepth, sqrtSensorNo, len, offset, shape);}
+    bool operator<(const Genome& other) const {return key() < other.key();}
+};
+
+struct Score
+{
+    double hits;        //mean hits per track
+    double error;       //standard error of the mean
+    double sensorNo;
+};
+
+//a track from the bank, the start point is stored as a fraction of the detector size so it fits any layout
+struct Track
+{
+    double fx, fy, fz;
+    double a, b, c;
+};
+
+
+/*
+This function moves a genome back into the allowed ranges and onto the size grid, the pixel is widened if the sensor
+does not fit on it
+
+inputs:
+        genome: Genome, called by reference and corrected in place
+*/
+
+void repair(Genome& genome)
+{
+    genome.sqrtSensorNo = std::clamp(genome.sqrtSensorNo, 1, 60);
+    genome.len = std::clamp(genome.len - genome.len % 2, 4, 20);
+    genome.offset = std::clamp(genome.offset, 0, static_cast<int>(offsetPatterns.size()) - 1);
+    genome.shape = std::clamp(genome.shape, 0, 1);
+
+    double sensorSize{2 * sensorPitch * genome.sqrtSensorNo};
+    genome.pixelWidth = std::max(std::clamp(genome.pixelWidth, 20.0, 120.0), sensorSize);
+    genome.pixelHeight = std::clamp(genome.pixelHeight, 10.0, 60.0);
+    genome.pixelDepth = std::max(std::clamp(genome.pixelDepth, 10.0, 40.0), sensorSize);
+
+    genome.pixelWidth = std::ceil(genome.pixelWidth / sizeStep) * sizeStep;
+    genome.pixelHeight = std::round(genome.pixelHeight / sizeStep) * sizeStep;
+    genome.pixelDepth = std::ceil(genome.pixelDepth / sizeStep) * sizeStep;
+}
+
+/*
+This function counts the sensors that one track passes through. As the sensors are no larger than the pixel, the
+intercept on each plane can only be inside the sensor with the nearest centre, so only that one is tested rather
+than the whole plane
+
+inputs:
+        genome: Genome, the layout
+        track: Track, the track
+
+outputs:
+        int, the number of hits
+*/
+
+int countHits(const Genome& genome, const Track& track)
+{
+    const int len{genome.len};
+    const double half{sensorPitch * genome.sqrtSensorNo};
+
+    double x1{(0.1 + 0.8 * track.fx) * len * genome.pixelWidth};
+    double y1{(0.1 + 0.8 * track.fy) * len * genome.pixelHeight};
+    double z1{(0.1 + 0.8 * track.fz) * len * genome.pixelDepth};
+
+    int hits{0};
+    for(int parity{0}; parity < 2; ++parity)
+    {
+        double offsetX{parity * offsetPatterns[genome.offset][0]};
+        double offsetY{parity * offsetPatterns[genome.offset][1]};
+        int layers{(len - parity + 1) / 2};
+
+        for(int row{0}; row < len; ++row)
+        {
+            double planeY{(row + offsetY) * genome.pixelHeight};
+            int hitX{-1};
+            int hitZ{-1};
+            for(double side : {-1.0, 1.0})
+            {
+                double ix{(track.a / track.b) * (planeY + side * sensorHeight - y1) + x1};
+                double iz{(track.c / track.b) * (planeY + side * sensorHeight - y1) + z1};
+
+                double kx{std::round(ix / genome.pixelWidth - offsetX)};
+                double kz{std::round((iz / genome.pixelDepth - parity) / 2)};
+                if(kx < 0 || kx >= len || kz < 0 || kz >= layers) {continue;}
+
+                double dx{ix - (kx + offsetX) * genome.pixelWidth};
+                double dz{iz - (2 * kz + parity) * genome.pixelDepth};
+                bool inside{genome.shape == 0 ? (std::fabs(dx) < half && std::fabs(dz) < half)
+                                              : (dx * dx + dz * dz < half * half)};
+
+                //a track through the top and bottom of the same sensor is one hit
+                if(inside && !(kx == hitX && kz == hitZ))
+                {
+                    ++hits;
+                    hitX = static_cast<int>(kx);
+                    hitZ = static_cast<int>(kz);
+                }
+            }
+        }
+    }
+    return hits;
+}
+
+Score evaluate(const Genome& genome, const std::vector<Track>& bank)
+{
+    double sum{0};
+    double sumSquares{0};
+    for(const Track& track : bank)
+    {
+        int hits{countHits(genome, track)};
+        sum += hits;
+        sumSquares += static_cast<double>(hits) * hits;
+    }
+    double n{static_cast<double>(bank.size())};
+    double mean{sum / n};
+    double variance{std::max(0.0, sumSquares / n - mean * mean)};
+    double sensorNo{static_cast<double>(genome.len) * genome.len * genome.len * genome.sqrtSensorNo * genome.sqrtSensorNo};
+    return Score{mean, std::sqrt(variance / n), sensorNo};
+}
+
+/*
+This function scores every genome that is not in the cache yet, sharing them out between all cores
+
+inputs:
+        population: the genomes to score
+        bank: the fixed bank of tracks
+        cache: map of every genome scored so far, called by reference and added to
+*/
+
+void evaluatePopulation(const std::vector<Genome>& population, const std::vector<Track>& bank, std::map<Genome, Score>& cache)
+{
+    std::vector<Genome> pending{};
+    for(const Genome& genome : population)
+    {
+        if(cache.find(genome) == cache.end() && std::find_if(pending.begin(), pending.end(),
+           [&genome](const Genome& other) {return !(genome < other) && !(other < genome);}) == pending.end())
+        {
+            pending.push_back(genome);
+        }
+    }
+
+    std::vector<Score> scores(pending.size());
+    std::atomic<std::size_t> next{0};
+    unsigned int threadNo{std::max(1u, std::thread::hardware_concurrency())};
+    std::vector<std::thread> threads{};
+    for(unsigned int t{0}; t < threadNo; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            for(std::size_t i{next++}; i < pending.size(); i = next++)
+            {
+                scores[i] = evaluate(pending[i], bank);
+            }
+        });
+    }
+    for(std::thread& thread : threads) {thread.join();}
+
+    for(std::size_t i{0}; i < pending.size(); ++i)
+    {
+        cache[pending[i]] = scores[i];
+    }
+}
+
+//true if a is at least as good as b in both objectives and better in one
+bool dominates(const Score& a, const Score& b)
+{
+    return (a.hits >= b.hits && a.sensorNo <= b.sensorNo) && (a.hits > b.hits || a.sensorNo < b.sensorNo);
+}
+
+/*
+This function sorts a population into fronts of non-dominated layouts and gives each layout a crowding distance,
+so that selection prefers better fronts and, within a front, the layouts in the least crowded places
+
+inputs:
+        population: the genomes, all of which are in the cache
+        cache: the scores
+        rank, crowding: empty vectors called by reference
+
+outputs:
+        this is void, it 'returns' rank and crowding as they are called by reference
+*/
+
+void rankPopulation(const std::vector<Genome>& population, const std::map<Genome, Score>& cache,
+                    std::vector<int>& rank, std::vector<double>& crowding)
+{
+    const std::size_t n{population.size()};
+    std::vector<Score> scores{};
+    for(const Genome& genome : population) {scores.push_back(cache.at(genome));}
+
+    rank.assign(n, -1);
+    crowding.assign(n, 0);
+    std::size_t ranked{0};
+    for(int front{0}; ranked < n; ++front)
+    {
+        std::vector<std::size_t> members{};
+        for(std::size_t i{0}; i < n; ++i)
+        {
+            if(rank[i] != -1) {continue;}
+            bool dominated{false};
+            for(std::size_t j{0}; j < n && !dominated; ++j)
+            {
+                dominated = rank[j] == -1 && j != i && dominates(scores[j], scores[i]);
+            }
+            if(!dominated) {members.push_back(i);}
+        }
+        for(std::size_t i : members) {rank[i] = front;}
+        ranked += members.size();
+
+        //crowding distance along each objective, the ends of the front are always kept
+        for(int objective{0}; objective < 2; ++objective)
+        {
+            auto value{[&](std::size_t i) {return objective == 0 ? scores[i].hits : scores[i].sensorNo;}};
+            std::sort(members.begin(), members.end(), [&](std::size_t a, std::size_t b) {return value(a) < value(b);});
+            double range{value(members.back()) - value(members.front())};
+            crowding[members.front()] = crowding[members.back()] = 1e300;
+            for(std::size_t m{1}; m + 1 < members.size(); ++m)
+            {
+                if(range > 0) {crowding[members[m]] += (value(members[m + 1]) - value(members[m - 1])) / range;}
+            }
+        }
+    }
+}
+
+Genome randomGenome(std::mt19937_64& gen)
+{
+    std::uniform_real_distribution<double> unif(0, 1);
+    Genome genome{20 + 100 * unif(gen), 10 + 50 * unif(gen), 10 + 30 * unif(gen),
+                  1 + static_cast<int>(59 * unif(gen)), 4 + 2 * static_cast<int>(9 * unif(gen)),
+                  static_cast<int>(offsetPatterns.size() * unif(gen)), static_cast<int>(2 * unif(gen))};
+    repair(genome);
+    return genome;
+}
+
+/*
+This function makes a child from two parents, taking each gene from either parent at random then mutating it
+
+inputs:
+        mother, father: Genome, the parents
+        gen: the random number generator
+
+outputs:
+        Genome, the child
+*/
+
+Genome breed(const Genome& mother, const Genome& father, std::mt19937_64& gen)
+{
+    std::uniform_real_distribution<double> unif(0, 1);
+    std::normal_distribution<double> normal(0, 1);
+    auto pick{[&](auto a, auto b) {return unif(gen) < 0.5 ? a : b;}};
+
+    Genome child{pick(mother.pixelWidth, father.pixelWidth), pick(mother.pixelHeight, father.pixelHeight),
+                 pick(mother.pixelDepth, father.pixelDepth), pick(mother.sqrtSensorNo, father.sqrtSensorNo),
+                 pick(mother.len, father.len), pick(mother.offset, father.offset), pick(mother.shape, father.shape)};
+
+    const double rate{0.3};
+    if(unif(gen) < rate) {child.pixelWidth += 10 * normal(gen);}
+    if(unif(gen) < rate) {child.pixelHeight += 5 * normal(gen);}
+    if(unif(gen) < rate) {child.pixelDepth += 3 * normal(gen);}
+    if(unif(gen) < rate) {child.sqrtSensorNo += static_cast<int>(std::lround(5 * normal(gen)));}
+    if(unif(gen) < rate) {child.len += 2 * static_cast<int>(std::lround(normal(gen)));}
+    if(unif(gen) < rate / 3) {child.offset = static_cast<int>(offsetPatterns.size() * unif(gen));}
+    if(unif(gen) < rate / 3) {child.shape = 1 - child.shape;}
+
+    repair(child);
+    return child;
+}
+
+int main(int argc, char* argv[])
+{
+    int generations{argc > 1 ? std::stoi(argv[1]) : 30};
+    std::size_t populationSize{argc > 2 ? static_cast<std::size_t>(std::stoi(argv[2])) : 48};
+    std::size_t bankSize{argc > 3 ? static_cast<std::size_t>(std::stoi(argv[3])) : 20000};
+
+    //the fixed bank of tracks every layout is scored on
+    std::mt19937_64 bankGen(2023);
+    std::uniform_real_distribution<double> fraction(0, 1);
+    std::uniform_real_distribution<double> direction(-100, 100);
+    std::vector<Track> bank(bankSize);
+    for(Track& track : bank)
+    {
+        track = Track{fraction(bankGen), fraction(bankGen), fraction(bankGen),
+                      direction(bankGen), direction(bankGen), direction(bankGen)};
+    }
+
+    std::mt19937_64 gen(1);
+    std::map<Genome, Score> cache{};
+
+    //start from the layout in Finalised3DCuboidSImulation.cpp and random layouts
+    std::vector<Genome> population{Genome{80, 29, 19, 40, 14, 1, 0}};
+    repair(population.front());
+    while(population.size() < populationSize) {population.push_back(randomGenome(gen));}
+    evaluatePopulation(population, bank, cache);
+
+    std::vector<int> rank{};
+    std::vector<double> crowding{};
+    for(int generation{1}; generation <= generations; ++generation)
+    {
+        rankPopulation(population, cache, rank, crowding);
+
+        //binary tournaments on front, then crowding
+        auto select{[&]() -> const Genome&
+        {
+            std::uniform_int_distribution<std::size_t> index(0, population.size() - 1);
+            std::size_t a{index(gen)};
+            std::size_t b{index(gen)};
+            bool aBetter{rank[a] < rank[b] || (rank[a] == rank[b] && crowding[a] > crowding[b])};
+            return population[aBetter ? a : b];
+        }};
+
+        std::vector<Genome> combined{population};
+        for(std::size_t i{0}; i < populationSize; ++i)
+        {
+            combined.push_back(breed(select(), select(), gen));
+        }
+        evaluatePopulation(combined, bank, cache);
+
+        //the best of parents and children survive, without duplicates
+        std::sort(combined.begin(), combined.end());
+        combined.erase(std::unique(combined.begin(), combined.end(),
+                       [](const Genome& a, const Genome& b) {return !(a < b) && !(b < a);}), combined.end());
+        rankPopulation(combined, cache, rank, crowding);
+        std::vector<std::size_t> order(combined.size());
+        for(std::size_t i{0}; i < order.size(); ++i) {order[i] = i;}
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+        {
+            return rank[a] < rank[b] || (rank[a] == rank[b] && crowding[a] > crowding[b]);
+        });
+
+        population.clear();
+        for(std::size_t i{0}; i < std::min(populationSize, order.size()); ++i) {population.push_back(combined[order[i]]);}
+
+        std::cout << "Generation " << generation << ": " << cache.size() << " layouts evaluated\n";
+    }
+
+    //the Pareto front over every layout that was evaluated, in order of sensor count
+    std::vector<std::pair<Genome, Score>> front{};
+    for(const auto& [genome, score] : cache)
+    {
+        bool dominated{false};
+        for(const auto& other : cache)
+        {
+            if(dominates(other.second, score)) {dominated = true; break;}
+        }
+        if(!dominated) {front.emplace_back(genome, score);}
+    }
+    std::sort(front.begin(), front.end(), [](const auto& a, const auto& b) {return a.second.sensorNo < b.second.sensorNo;});
+
+    std::cout << "\nPareto front, " << bank.size() << " tracks per layout\n";
+    std::cout << "sensorNo\thits\terror\tlen\tpixelWidth\tpixelHeight\tpixelDepth\tsqrtSensorNo\toffset\tshape\n";
+    for(const auto& [genome, score] : front)
+    {
+        std::cout << score.sensorNo << '\t' << score.hits << '\t' << score.error << '\t' << genome.len << '\t'
+                  << genome.pixelWidth << '\t' << genome.pixelHeight << '\t' << genome.pixelDepth << '\t'
+                  << genome.sqrtSensorNo << '\t' << offsetNames[genome.offset] << '\t' << shapeNames[genome.shape] << '\n';
+    }
+
+    return 0;
+}
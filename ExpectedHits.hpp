@@ -0,0 +1,349 @@
+#ifndef EXPECTED_HITS_HPP
+#define EXPECTED_HITS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+Semi-analytic expected number of hits per track for the periodic lattices in Finalised3DCuboidSImulation.cpp and
+Finalised2DRectangleSimultation.cpp.
+
+The Monte Carlo draws a point uniformly inside the detector and a direction, and counts the sensors the line crosses.
+For a fixed direction the position part of that average is done here in closed form: at a sensor plane the x and z
+intercepts are the start point shifted by a slope, so the chance of landing on a sensor is an interval overlap in x
+times an interval overlap in z. Summed over a whole row of the lattice that overlap only depends on a periodic comb
+of intervals sliding across a window, which also has a closed form. What is left (the start height and the
+direction) is done by Gauss-Legendre quadrature.
+*/
+
+
+//parameters of the offset cuboid lattice, the sensor sizes are half lengths exactly as they are used in getHits
+struct CuboidLayout
+{
+    int len;                //number of pixels along each side of the detector
+    double pixelWidth;      //size of pixel in x axis
+    double pixelHeight;     //size of pixel in y axis
+    double pixelDepth;      //size of pixel in z axis
+    double sensorWidth;     //half size of the sensor in x axis
+    double sensorDepth;     //half size of the sensor in z axis
+    double sensorHeight;    //half thickness of the sensor in y axis
+};
+
+//parameters of the 2D offset rectangle detector, the diode sizes are half lengths as in the simulation
+struct RectangleLayout
+{
+    int len;                //number of pixels along each row
+    double pixelWidth;      //size of pixel in x axis
+    double pixelHeight;     //size of pixel in y axis
+    double width;           //half width of the diode
+    double height;          //half height of the diode
+    double maxGradient;     //tracks are x = m * y + c with m uniform in [-maxGradient, maxGradient]
+};
+
+//number of quadrature nodes, the defaults agree with 10^6 track Monte Carlo runs to well inside their error bars
+struct QuadratureSettings
+{
+    int directionNodes{4};      //Gauss-Legendre nodes on each half of a direction axis, on each of the three faces of the cube
+    int heightPanels{6};        //panels of the 4 point rule used for the start height of the track
+};
+
+
+/*
+This function fills nodes and weights for n point Gauss-Legendre quadrature on [-1, 1], using Newton's method on
+the Legendre polynomial
+
+inputs:
+        n: int, the number of nodes
+        nodes, weights: empty vectors called by reference
+
+outputs:
+        this is void, it 'returns' the nodes and weights as they are called by reference
+*/
+
+inline void gaussLegendre(int n, std::vector<double>& nodes, std::vector<double>& weights)
+{
+    const double pi{3.14159265358979323846};
+    nodes.assign(n, 0);
+    weights.assign(n, 0);
+    for(int i{0}; i < (n + 1) / 2; ++i)
+    {
+        double x{std::cos(pi * (i + 0.75) / (n + 0.5))};
+        double derivative{1};
+        for(int iteration{0}; iteration < 100; ++iteration)
+        {
+            //recurrence for P_n(x), and its derivative from P_n and P_(n-1)
+            double p0{1};
+            double p1{x};
+            for(int k{2}; k <= n; ++k)
+            {
+                double p2{((2 * k - 1) * x * p1 - (k - 1) * p0) / k};
+                p0 = p1;
+                p1 = p2;
+            }
+            if(n == 1) {p0 = 1;}
+            derivative = n * (x * p1 - p0) / (x * x - 1);
+            double step{p1 / derivative};
+            x -= step;
+            if(std::fabs(step) < 1e-15) {break;}
+        }
+        nodes[i] = -x;
+        nodes[n - 1 - i] = x;
+        weights[i] = 2 / ((1 - x * x) * derivative * derivative);
+        weights[n - 1 - i] = weights[i];
+    }
+}
+
+/*
+This function returns the summed length of a comb of intervals that lies below t, the intervals are
+[first + k * pitch - half, first + k * pitch + half] for k = 0 ... count - 1. Overlapping intervals are each counted,
+just as overlapping sensors would each record a hit
+
+inputs:
+        t: double, the upper limit
+        first: double, centre of the first interval
+        pitch: double, spacing of the interval centres
+        count: int, number of intervals
+        half: double, half length of each interval
+
+outputs:
+        double, the summed length
+*/
+
+inline double combBelow(double t, double first, double pitch, int count, double half)
+{
+    if(half <= 0 || count <= 0) {return 0;}
+    //each interval contributes clamp(a - k * pitch, 0, 2 * half)
+    double a{t - first + half};
+    if(a <= 0) {return 0;}
+
+    //intervals that lie fully below t
+    double lastFull{std::floor((a - 2 * half) / pitch)};
+    lastFull = std::min(std::max(lastFull, -1.0), count - 1.0);
+    //intervals that t cuts through
+    double lastPartial{std::ceil(a / pitch) - 1};
+    lastPartial = std::min(lastPartial, count - 1.0);
+
+    double length{(lastFull + 1) * 2 * half};
+    if(lastPartial > lastFull)
+    {
+        double m{lastPartial - lastFull};
+        double sumK{(lastFull + 1 + lastPartial) * m / 2};
+        length += m * a - pitch * sumK;
+    }
+    return length;
+}
+
+/*
+This function returns the summed overlap of a comb of intervals (see combBelow) with the window [lower, upper]
+*/
+
+inline double combOverlap(double lower, double upper, double first, double pitch, int count, double half)
+{
+    if(upper <= lower) {return 0;}
+    return combBelow(upper, first, pitch, count, half) - combBelow(lower, first, pitch, count, half);
+}
+
+/*
+This function returns the expected hits for one track direction, averaged over the start point of the track which
+is uniform in the middle 80% of the detector in each axis, as in the Monte Carlo
+
+inputs:
+        layout: CuboidLayout, the detector
+        u, v: double, the slopes dx/dy and dz/dy of the track (a / b and c / b in the simulation)
+        heightNodes, heightWeights: the composite quadrature rule for the start height, mapped onto the y range
+
+outputs:
+        double, the expected number of hits
+*/
+
+inline double cuboidHitsForDirection(const CuboidLayout& layout, double u, double v,
+                                     const std::vector<double>& heightNodes, const std::vector<double>& heightWeights)
+{
+    const int len{layout.len};
+    const double xLower{0.1 * len * layout.pixelWidth};
+    const double xUpper{0.9 * len * layout.pixelWidth};
+    const double yRange{0.8 * len * layout.pixelHeight};
+    const double zLower{0.1 * len * layout.pixelDepth};
+    const double zUpper{0.9 * len * layout.pixelDepth};
+    const double area{(xUpper - xLower) * (zUpper - zLower)};
+
+    const double sw{layout.sensorWidth};
+    const double sd{layout.sensorDepth};
+    const double s{layout.sensorHeight};
+
+    //the two planes of a sensor shift the intercept by this much relative to each other
+    const double xGap{std::fabs(u * 2 * s)};
+    const double zGap{std::fabs(v * 2 * s)};
+
+    double hits{0};
+    for(int parity{0}; parity < 2; ++parity)
+    {
+        //even z layers sit on the lattice, odd z layers are offset by half a pixel in x and y
+        const double xFirst{0.5 * parity * layout.pixelWidth};
+        const double zFirst{parity * layout.pixelDepth};
+        const int zCount{(len - parity + 1) / 2};
+        const double zPitch{2 * layout.pixelDepth};
+
+        for(int row{0}; row < len; ++row)
+        {
+            const double planeY{(row + 0.5 * parity) * layout.pixelHeight};
+            double rowHits{0};
+            for(std::size_t n{0}; n < heightNodes.size(); ++n)
+            {
+                //the start point (x1, z1) hits the sensor at (cx, cz) if it lies within the sensor shifted back by the slope
+                double bottomShiftX{u * (planeY - s - heightNodes[n])};
+                double topShiftX{u * (planeY + s - heightNodes[n])};
+                double bottomShiftZ{v * (planeY - s - heightNodes[n])};
+                double topShiftZ{v * (planeY + s - heightNodes[n])};
+
+                double xBottom{combOverlap(xLower, xUpper, xFirst - bottomShiftX, layout.pixelWidth, len, sw)};
+                double xTop{combOverlap(xLower, xUpper, xFirst - topShiftX, layout.pixelWidth, len, sw)};
+                double xBoth{combOverlap(xLower, xUpper, xFirst - 0.5 * (bottomShiftX + topShiftX), layout.pixelWidth, len, sw - 0.5 * xGap)};
+
+                double zBottom{combOverlap(zLower, zUpper, zFirst - bottomShiftZ, zPitch, zCount, sd)};
+                double zTop{combOverlap(zLower, zUpper, zFirst - topShiftZ, zPitch, zCount, sd)};
+                double zBoth{combOverlap(zLower, zUpper, zFirst - 0.5 * (bottomShiftZ + topShiftZ), zPitch, zCount, sd - 0.5 * zGap)};
+
+                //a hit through the bottom or the top plane, not counting tracks through both twice
+                rowHits += heightWeights[n] * (xBottom * zBottom + xTop * zTop - xBoth * zBoth);
+            }
+            hits += rowHits;
+        }
+    }
+    return hits / (area * yRange);
+}
+
+/*
+This function returns the expected number of hits per track for the cuboid detector
+
+The simulation takes the direction (a, b, c) uniform in a cube, so the direction is uniform over the faces of the
+cube. On the face where |b| is largest (a / b, c / b) is uniform in [-1, 1]^2, and the other two faces are handled
+the same way with the roles of the components swapped. Each face carries a third of the tracks.
+
+inputs:
+        layout: CuboidLayout, the detector
+        settings: QuadratureSettings, the number of quadrature nodes
+
+outputs:
+        double, the expected number of hits per track
+*/
+
+inline double expectedHitsCuboid(const CuboidLayout& layout, const QuadratureSettings& settings = QuadratureSettings{})
+{
+    //the expected hits have a kink where a face parameter crosses 0 (the track turns parallel to a plane), so each
+    //axis is split there and integrated as two halves
+    std::vector<double> halfNodes{};
+    std::vector<double> halfWeights{};
+    gaussLegendre(settings.directionNodes, halfNodes, halfWeights);
+    std::vector<double> directionNodes{};
+    std::vector<double> directionWeights{};
+    for(double sign : {-1.0, 1.0})
+    {
+        for(std::size_t n{0}; n < halfNodes.size(); ++n)
+        {
+            directionNodes.push_back(sign * 0.5 * (halfNodes[n] + 1));
+            directionWeights.push_back(0.5 * halfWeights[n]);
+        }
+    }
+
+    //composite 4 point rule over the start height range
+    std::vector<double> panelNodes{};
+    std::vector<double> panelWeights{};
+    gaussLegendre(4, panelNodes, panelWeights);
+
+    const double yLower{0.1 * layout.len * layout.pixelHeight};
+    const double yUpper{0.9 * layout.len * layout.pixelHeight};
+    const double panel{(yUpper - yLower) / settings.heightPanels};
+    std::vector<double> heightNodes{};
+    std::vector<double> heightWeights{};
+    for(int p{0}; p < settings.heightPanels; ++p)
+    {
+        for(std::size_t n{0}; n < panelNodes.size(); ++n)
+        {
+            heightNodes.push_back(yLower + panel * (p + 0.5 * (panelNodes[n] + 1)));
+            heightWeights.push_back(0.5 * panel * panelWeights[n]);
+        }
+    }
+
+    double hits{0};
+    for(std::size_t i{0}; i < directionNodes.size(); ++i)
+    {
+        for(std::size_t j{0}; j < directionNodes.size(); ++j)
+        {
+            double alpha{directionNodes[i]};
+            double beta{directionNodes[j]};
+            double weight{directionWeights[i] * directionWeights[j] / 4};
+
+            //|b| largest
+            hits += weight * cuboidHitsForDirection(layout, alpha, beta, heightNodes, heightWeights);
+            //|a| largest, alpha = b / a and beta = c / a
+            hits += weight * cuboidHitsForDirection(layout, 1 / alpha, beta / alpha, heightNodes, heightWeights);
+            //|c| largest, alpha = a / c and beta = b / c
+            hits += weight * cuboidHitsForDirection(layout, alpha / beta, 1 / beta, heightNodes, heightWeights);
+        }
+    }
+    return hits / 3;
+}
+
+/*
+This function returns the expected number of hits per track for the 2D rectangle detector. A line x = m * y + c
+crosses a diode when c lies between the smallest and largest value of x - m * y over the diode corners, so for a
+fixed gradient the probability is an interval overlap with the range of c. That is linear in m between a few break
+points, so the integral over m is done exactly with the midpoint of each linear piece
+
+inputs:
+        layout: RectangleLayout, the detector
+
+outputs:
+        double, the expected number of hits per track
+*/
+
+inline double expectedHitsRectangle(const RectangleLayout& layout)
+{
+    const int len{layout.len};
+    const double cUpper{len * layout.pixelWidth};
+    const double maxM{layout.maxGradient};
+
+    double hits{0};
+    //pairs of rows every 3 pixel heights, the second row of each pair is offset by half a pixel
+    for(int i{0}; i < len - 2; i += 3)
+    {
+        for(int row{0}; row < 2; ++row)
+        {
+            double py{(i + row) * layout.pixelHeight};
+            for(int k{0}; k < len; ++k)
+            {
+                double px{(k + 0.5 * row) * layout.pixelWidth};
+
+                std::vector<double> breaks{-maxM, 0, maxM};
+                for(double sign : {-1.0, 1.0})
+                {
+                    //on each side of m = 0 the ends of the range of c are lower + m * lowerSlope and upper + m * upperSlope
+                    double lowerSlope{-py - sign * layout.height};
+                    double upperSlope{-py + sign * layout.height};
+                    for(double limit : {0.0, cUpper})
+                    {
+                        for(double m : {(limit - (px - layout.width)) / lowerSlope, (limit - (px + layout.width)) / upperSlope})
+                        {
+                            if(std::isfinite(m) && m * sign > 0 && std::fabs(m) < maxM) {breaks.push_back(m);}
+                        }
+                    }
+                }
+                std::sort(breaks.begin(), breaks.end());
+
+                for(std::size_t b{0}; b + 1 < breaks.size(); ++b)
+                {
+                    double m{0.5 * (breaks[b] + breaks[b + 1])};
+                    double lower{px - layout.width - m * py - std::fabs(m) * layout.height};
+                    double upper{px + layout.width - m * py + std::fabs(m) * layout.height};
+                    double overlap{std::max(0.0, std::min(upper, cUpper) - std::max(lower, 0.0))};
+                    hits += (breaks[b + 1] - breaks[b]) * overlap;
+                }
+            }
+        }
+    }
+    return hits / (2 * maxM * cUpper);
+}
+
+#endif
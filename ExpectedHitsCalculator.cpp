@@ -0,0 +1,67 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+
+#include "ExpectedHits.hpp"
+
+/*
+Computes the expected number of hits per track without running the Monte Carlo, see ExpectedHits.hpp
+
+With no arguments it prints the expected hits for the detectors set up in Finalised3DCuboidSImulation.cpp and
+Finalised2DRectangleSimultation.cpp (including the same sweep over pixel width as the 2D simulation).
+
+With the argument "screen" it reads candidate cuboid layouts from the standard input, one per line as
+        len pixelWidth pixelHeight pixelDepth sqrtSensorNo
+and prints each layout followed by its number of sensors and expected hits per track, so a large list of layouts can be
+cut down before any Monte Carlo time is spent on them.
+*/
+
+int main(int argc, char* argv[])
+{
+    //sensor sizes as used in the cuboid simulation, multiple sensors are merged into 1 wider sensor
+    const double sensorPitch{0.236};
+    const double sensorHeight{6e-3};
+
+    if(argc > 1 && std::string(argv[1]) == "screen")
+    {
+        int len{0};
+        double pixelWidth{0};
+        double pixelHeight{0};
+        double pixelDepth{0};
+        int sqrtSensorNo{0};
+        while(std::cin >> len >> pixelWidth >> pixelHeight >> pixelDepth >> sqrtSensorNo)
+        {
+            CuboidLayout layout{len, pixelWidth, pixelHeight, pixelDepth,
+                                sensorPitch * sqrtSensorNo, sensorPitch * sqrtSensorNo, sensorHeight};
+            long long sensorNo{static_cast<long long>(len) * len * len * sqrtSensorNo * sqrtSensorNo};
+
+            std::cout << len << ' ' << pixelWidth << ' ' << pixelHeight << ' ' << pixelDepth << ' ' << sqrtSensorNo << ' '
+                      << sensorNo << ' ' << expectedHitsCuboid(layout) << '\n';
+        }
+        return 0;
+    }
+
+    //the cuboid detector from Finalised3DCuboidSImulation.cpp
+    int sqrtSensorNo{40};
+    CuboidLayout cuboid{14, 80, 29, 19, sensorPitch * sqrtSensorNo, sensorPitch * sqrtSensorNo, sensorHeight};
+
+    auto start{std::chrono::steady_clock::now()};
+    double cuboidHits{expectedHitsCuboid(cuboid)};
+    auto end{std::chrono::steady_clock::now()};
+
+    std::cout << "Cuboid detector, expected hits per track: " << cuboidHits << '\n';
+    std::cout << "Time taken: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n\n";
+
+    //the 2D detector from Finalised2DRectangleSimultation.cpp, sweeping the pixel width as the simulation does
+    start = std::chrono::steady_clock::now();
+    std::cout << "2D detector, pixel width: expected hits per track\n";
+    for(double z{13}; z < 100; z += 5)
+    {
+        RectangleLayout rectangle{20, z, 9, 3.3, 3e-3, 5};
+        std::cout << z << ": " << expectedHitsRectangle(rectangle) << '\n';
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "Time taken: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+
+    return 0;
+}
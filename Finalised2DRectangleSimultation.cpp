@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <random>
 #include <math.h>
+#include <vector>
+
+#include "Clustering.hpp"
 
 //template to create 2D arrays more easily
 template <typename T, int Dim, int Len>
@@ -90,6 +93,10 @@ int main()
     //generating the random double
 
     int totalHits {0};
+    int totalClusters {0};
+    //neighbouring pixels, including the offset row, are grouped into clusters of hits
+    ClusterArena<area> arena{};
+    const std::array<double, dim> spacing{pixelWidth, pixelHeight};
     int runs{10};
     // this allows for multiple runs of the code to et a good average of the number of hits
     //blank out the printing section at the bottom if you want many runs
@@ -180,6 +187,10 @@ int main()
 
 
     std::cout << "No. of collisions: " << locations.size() << '\n';
+    int clusters{arena.cluster(locations, [&](int first, int second) {return latticeNeighbours(pixels, first, second, spacing);})};
+    std::cout << "No. of clusters: " << clusters << ", sizes:";
+    for(int c{0}; c < clusters; ++c) {std::cout << ' ' << arena.clusterSize(c);}
+    std::cout << '\n';
     //printing the indices of the pixels hit
     std::cout << "index of pixels collided with: " << '\n';
     for (int i{0}; i < std::size(locations); ++i) 
@@ -235,11 +246,13 @@ int main()
 
     //summing the total number of hits from multiple runs of the code
     totalHits += locations.size();
+    totalClusters += clusters;
     }
 
     std::cout << "Pixel width: " << z << '\n';
     std::cout << "Total hits: " << totalHits << '\n';
-    std::cout << "Average hits: " << static_cast<double>(totalHits) / runs << '\n' << '\n';
+    std::cout << "Average hits: " << static_cast<double>(totalHits) / runs << '\n';
+    std::cout << "Average clusters: " << static_cast<double>(totalClusters) / runs << '\n' << '\n';
     }
     return 0;
 }
\ No newline at end of file
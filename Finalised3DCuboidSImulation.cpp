@@ -4,6 +4,26 @@
 #include <random>
 #include <math.h>
 #include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+#include <thread>
+#include <functional>
+#include <optional>
+
+#include "TrackRandom.hpp"
+#include "TrackGenerator.hpp"
+#include "RunStatistics.hpp"
+#include "ResultCache.hpp"
+#include "Checkpoint.hpp"
+#include "ShardResult.hpp"
+#include "EventQueue.hpp"
+#include "Clustering.hpp"
+#include "Reconstruction.hpp"
+#include "HoughFinder.hpp"
+#include "EventModel.hpp"
+#include "Digitisation.hpp"
 
 //this template is used to create a 2D array more simply
 template <typename T, int Dim, int Vol>
@@ -52,23 +72,6 @@ void createCoords(Array2d<T, Dim, Vol>& pixels, int len, double pixelWidth, doub
     }
 }
 
-/*
-This function returns a random double value, uniformly distributed between the upper and lower bound
-
-input:
-        upper: double, the upper bound for the random number
-        lower: double, the lower bound for the random number    
-output:
-        unif(rand): double, a randomly generated value
-*/
-
-double randomNumber(double upper, double lower)
-{
-    std::uniform_real_distribution<double> unif(lower, upper);
-    std::random_device rand;
-    return unif(rand);
-}
-
 /*
 This function find the x-z coordinate for the intercept of a random line with each y plane which represents
 the top and bottom of the diodes
@@ -114,16 +117,17 @@ inputs:
         len: int, the number of pixels across each side of the detector
         sensorWidth: double, the length of the diodes in the y axis
         sensorHeight: double, the length of the diodes in the y axis
+        locations: an empty vector called by reference, filled with the id x + len * y + len * len * z of each hit pixel
 
 outputs: 
         locations.size(): sint, the number of hits
 */
 
 template<typename T, std::size_t Dim, std::size_t Vol, typename C, std::size_t Dim2, std::size_t Vol2>
-int getHits(Array2d<T, Dim, Vol>& pixels, Array2d<C, Dim2, Vol2>& planeIntercepts, int len, double sensorWidth, double sensorDepth)
+int getHits(Array2d<T, Dim, Vol>& pixels, Array2d<C, Dim2, Vol2>& planeIntercepts, int len, double sensorWidth, double sensorDepth,
+            std::vector<int>& locations)
 {
-    std::vector<int> locations{};
-    locations.reserve(2 * len);
+    locations.clear();
     for(int z{0}; z < len; z += 2)
     {
         for (int y{0}; y < len; ++y)
@@ -133,40 +137,40 @@ int getHits(Array2d<T, Dim, Vol>& pixels, Array2d<C, Dim2, Vol2>& planeIntercept
                 //for both the top an bottom planes for the sensors, adding 1 to the greater variables if the particle is > the x and y coord
                 //if the particle passes through the sensor, the will not all be greater and not all less
                 int greaterBottom {0};
-                if((pixels[x + len * y + len * len * z][0] - sensorWidth < planeIntercepts[4 * z][0]) && (pixels[x + len * y + len * len * z][2] - sensorDepth < planeIntercepts[4 * z][1]))
+                if((pixels[x + len * y + len * len * z][0] - sensorWidth < planeIntercepts[4 * y][0]) && (pixels[x + len * y + len * len * z][2] - sensorDepth < planeIntercepts[4 * y][1]))
                 {++greaterBottom;}
-                if((pixels[x + len * y + len * len * z][0] + sensorWidth > planeIntercepts[4 * z][0]) && (pixels[x + len * y + len * len * z][2] + sensorDepth > planeIntercepts[4 * z][1]))
+                if((pixels[x + len * y + len * len * z][0] + sensorWidth > planeIntercepts[4 * y][0]) && (pixels[x + len * y + len * len * z][2] + sensorDepth > planeIntercepts[4 * y][1]))
                 {++greaterBottom;}
 
                 int greaterTop {0};
-                if((pixels[x + len * y + len * len * z][0] - sensorWidth < planeIntercepts[4 * z + 1][0]) && (pixels[x + len * y + len * len * z][2] - sensorDepth < planeIntercepts[4 * z + 1][1]))
+                if((pixels[x + len * y + len * len * z][0] - sensorWidth < planeIntercepts[4 * y + 1][0]) && (pixels[x + len * y + len * len * z][2] - sensorDepth < planeIntercepts[4 * y + 1][1]))
                 {++greaterTop;}
-                if((pixels[x + len * y + len * len * z][0] + sensorWidth > planeIntercepts[4 * z + 1][0]) && (pixels[x + len * y + len * len * z][2] + sensorDepth > planeIntercepts[4 * z + 1][1]))
+                if((pixels[x + len * y + len * len * z][0] + sensorWidth > planeIntercepts[4 * y + 1][0]) && (pixels[x + len * y + len * len * z][2] + sensorDepth > planeIntercepts[4 * y + 1][1]))
                 {++greaterTop;}
                 
                 //if the particle goes through the top or bottom plane, it has gone through the snensor
                 //if((greaterBottom != 0 && greaterBottom != 4) || (greaterTop != 0 && greaterTop != 4)) 
                 if((greaterBottom == 2) || ( greaterTop == 2)) 
                 { 
-                    locations.push_back(y);
+                    locations.push_back(x + len * y + len * len * z);
                 }
 
                 greaterBottom = 0;
-                if((pixels[x + len * y + len * len * (z + 1)][0] - sensorWidth < planeIntercepts[4 * z + 2][0]) && (pixels[x + len * y + len * len * (z + 1)][2] - sensorDepth < planeIntercepts[4 * z + 2][1]))
+                if((pixels[x + len * y + len * len * (z + 1)][0] - sensorWidth < planeIntercepts[4 * y + 2][0]) && (pixels[x + len * y + len * len * (z + 1)][2] - sensorDepth < planeIntercepts[4 * y + 2][1]))
                 {++greaterBottom;}
-                if((pixels[x + len * y + len * len * (z + 1)][0] + sensorWidth > planeIntercepts[4 * z + 2][0]) && (pixels[x + len * y + len * len * (z + 1)][2] + sensorDepth > planeIntercepts[4 * z + 1][1]))
+                if((pixels[x + len * y + len * len * (z + 1)][0] + sensorWidth > planeIntercepts[4 * y + 2][0]) && (pixels[x + len * y + len * len * (z + 1)][2] + sensorDepth > planeIntercepts[4 * y + 2][1]))
                 {++greaterBottom;}
 
                 greaterTop = 0;
-                if((pixels[x + len * y + len * len * (z + 1)][0] - sensorWidth < planeIntercepts[4 * z + 3][0]) && (pixels[x + len * y + len * len * (z + 1)][2] - sensorDepth < planeIntercepts[4 * z + 3][1]))
+                if((pixels[x + len * y + len * len * (z + 1)][0] - sensorWidth < planeIntercepts[4 * y + 3][0]) && (pixels[x + len * y + len * len * (z + 1)][2] - sensorDepth < planeIntercepts[4 * y + 3][1]))
                 {++greaterTop;}
-                if((pixels[x + len * y + len * len * (z + 1)][0] + sensorWidth > planeIntercepts[4 * z + 3][0]) && (pixels[x + len * y + len * len * (z + 1)][2] + sensorDepth > planeIntercepts[4 * z + 3][1]))
+                if((pixels[x + len * y + len * len * (z + 1)][0] + sensorWidth > planeIntercepts[4 * y + 3][0]) && (pixels[x + len * y + len * len * (z + 1)][2] + sensorDepth > planeIntercepts[4 * y + 3][1]))
                 {++greaterTop;}
                 
                 //if the particle goes through the top or bottom plane, it has gone through the snensor
                 if((greaterBottom ==2 ) || (greaterTop ==2)) 
                 { 
-                    locations.push_back(y);
+                    locations.push_back(x + len * y + len * len * (z + 1));
                 }
             }
         }
@@ -174,7 +178,142 @@ int getHits(Array2d<T, Dim, Vol>& pixels, Array2d<C, Dim2, Vol2>& planeIntercept
     return locations.size();
 }
 
-int main()
+/*
+This function finds the plane intercepts of all of the tracks of an event at once, as getIntercepts does for one track.
+The intercepts are kept plane by plane with the tracks side by side, so each plane is one loop over the tracks that the
+compiler can vectorise
+
+inputs:
+        interceptX, interceptZ: arrays called by reference, filled with the x and z intercept of track i with plane j
+                in [j][i], the planes in the order of getIntercepts
+        len: int, the number of pixels across each side of the detector
+        pixelHeight: double, the length of each pixel in the y axis
+        sensorHeight: double, the length of the diodes in the y axis
+        tracks: the tracks of the event, no more than fit in the arrays
+
+outputs:
+        this function is void, but 'returns' the intercepts as they are called by reference
+*/
+
+template <typename T, std::size_t Tracks, std::size_t Planes>
+void getEventIntercepts(std::array<std::array<T, Tracks>, Planes>& interceptX, std::array<std::array<T, Tracks>, Planes>& interceptZ,
+                        int len, double pixelHeight, double sensorHeight, const std::vector<Track>& tracks)
+{
+    std::size_t count{tracks.size()};
+    std::array<T, Tracks> slopeX{}, slopeZ{}, x1{}, y1{}, z1{};
+    for(std::size_t i{0}; i < count; ++i)
+    {
+        slopeX[i] = tracks[i].a / tracks[i].b;
+        slopeZ[i] = tracks[i].c / tracks[i].b;
+        x1[i] = tracks[i].x1;
+        y1[i] = tracks[i].y1;
+        z1[i] = tracks[i].z1;
+    }
+    for(int j{0}; j < 4 * len; ++j)
+    {
+        //the bottom and top of the sensors of layer j / 4, and of its offset layer half a pixel up
+        double height{(j / 4 + 0.5 * ((j / 2) % 2)) * pixelHeight + (j % 2 == 0 ? -sensorHeight : sensorHeight)};
+        for(std::size_t i{0}; i < count; ++i)
+        {
+            interceptX[j][i] = slopeX[i] * (height - y1[i]) + x1[i];
+            interceptZ[j][i] = slopeZ[i] * (height - y1[i]) + z1[i];
+        }
+    }
+}
+
+//a pixel index along one side, kept within [-1, len] in double before the cast, as the intercepts of a near horizontal
+//track can be far beyond the range of an int, a NaN intercept (a horizontal track) counts as below the lattice
+inline int latticeIndex(double index, int len)
+{
+    if(!(index > -1)) {return -1;}
+    return static_cast<int>(std::min(index, static_cast<double>(len)));
+}
+
+/*
+This function finds the pixels hit by the tracks of an event, as getHits does for one track, with each pixel once
+however many of the tracks went through it. Rather than testing every pixel against every track, each track is only
+tested against the few pixels of each layer around its intercepts, so the cost grows with the number of tracks and
+layers and not with the number of pixels
+
+inputs:
+        pixels: the coordinates of the pixel centres, as filled in by createCoords
+        interceptX, interceptZ: the intercepts of the tracks, as filled in by getEventIntercepts
+        count: the number of tracks in the event
+        len: int, the number of pixels across each side of the detector
+        pixelWidth, pixelDepth: double, the lengths of each pixel in the x and z axes
+        sensorWidth: double, the length of the diodes in the x axis
+        sensorDepth: double, the length of the diodes in the z axis
+        found: an empty vector called by reference, used to gather the hits of the tracks
+        locations: an empty vector called by reference, filled with the ids of the hit pixels in increasing order
+        owners: an empty vector called by reference, filled with a bit for each track through each hit pixel
+        trackHits: a vector called by reference, filled with the number of hits of each track
+
+outputs:
+        locations.size(): int, the number of hit pixels
+*/
+
+template <typename T, std::size_t Dim, std::size_t Vol, typename C, std::size_t Tracks, std::size_t Planes>
+int getEventHits(Array2d<T, Dim, Vol>& pixels, const std::array<std::array<C, Tracks>, Planes>& interceptX,
+                 const std::array<std::array<C, Tracks>, Planes>& interceptZ, int count, int len, double pixelWidth,
+                 double pixelDepth, double sensorWidth, double sensorDepth, std::vector<std::pair<int, std::uint64_t>>& found,
+                 std::vector<int>& locations, std::vector<std::uint64_t>& owners, std::vector<int>& trackHits)
+{
+    found.clear();
+    for(int y{0}; y < len; ++y)
+    {
+        //the even layers in z use the planes through the pixel row and the offset layers the planes half a pixel up
+        for(int offset{0}; offset < 2; ++offset)
+        {
+            const std::array<C, Tracks>& bottomX{interceptX[4 * y + 2 * offset]};
+            const std::array<C, Tracks>& bottomZ{interceptZ[4 * y + 2 * offset]};
+            const std::array<C, Tracks>& topX{interceptX[4 * y + 2 * offset + 1]};
+            const std::array<C, Tracks>& topZ{interceptZ[4 * y + 2 * offset + 1]};
+            for(int i{0}; i < count; ++i)
+            {
+                //the pixels whose sensors could hold either intercept, one more on each side to be safe from rounding,
+                //then the same test as getHits
+                int firstX{std::max(0, latticeIndex(std::floor((std::min(bottomX[i], topX[i]) - sensorWidth) / pixelWidth - 0.5 * offset), len))};
+                int lastX{std::min(len - 1, latticeIndex(std::ceil((std::max(bottomX[i], topX[i]) + sensorWidth) / pixelWidth - 0.5 * offset), len))};
+                int firstZ{std::max(0, latticeIndex(std::floor((std::min(bottomZ[i], topZ[i]) - sensorDepth) / pixelDepth), len))};
+                int lastZ{std::min(len - 1, latticeIndex(std::ceil((std::max(bottomZ[i], topZ[i]) + sensorDepth) / pixelDepth), len))};
+                for(int z{firstZ + (firstZ + offset) % 2}; z <= lastZ; z += 2)
+                {
+                    for(int x{firstX}; x <= lastX; ++x)
+                    {
+                        int id{x + len * y + len * len * z};
+                        double lowerX{pixels[id][0] - sensorWidth}, upperX{pixels[id][0] + sensorWidth};
+                        double lowerZ{pixels[id][2] - sensorDepth}, upperZ{pixels[id][2] + sensorDepth};
+                        bool bottom{lowerX < bottomX[i] && lowerZ < bottomZ[i] && upperX > bottomX[i] && upperZ > bottomZ[i]};
+                        bool top{lowerX < topX[i] && lowerZ < topZ[i] && upperX > topX[i] && upperZ > topZ[i]};
+                        if(bottom || top) {found.push_back({id, 1ULL << i});}
+                    }
+                }
+            }
+        }
+    }
+
+    //the hits of all of the tracks, with the bits of the tracks through each pixel put together
+    std::sort(found.begin(), found.end());
+    locations.clear();
+    owners.clear();
+    for(const std::pair<int, std::uint64_t>& hit : found)
+    {
+        if(!locations.empty() && locations.back() == hit.first) {owners.back() |= hit.second;}
+        else
+        {
+            locations.push_back(hit.first);
+            owners.push_back(hit.second);
+        }
+    }
+    trackHits.assign(count, 0);
+    for(std::uint64_t owner : owners)
+    {
+        for(int i{0}; i < count; ++i) {trackHits[i] += (owner >> i) & 1;}
+    }
+    return locations.size();
+}
+
+int main(int argc, char* argv[])
 {
     
         const int len{14};              //length of side of detector
@@ -195,36 +334,458 @@ int main()
 
         Array2d<double, dim, volume> pixels{};
 
+        //version of the simulation, increase it whenever a change alters the results so that results saved by
+        //older versions are not used any more
+        const int simulatorVersion{2};
+
+        //run settings, these can be changed from the command line
+        //  --pixel-width W, --pixel-height H, --pixel-depth D, --sensors N     the layout, N is sqrtSensorNo
+        //  --runs N        number of tracks (of events with --multiplicity or --find)
+        //  --seed S        seed of the random numbers
+        //  --tracks T      where the tracks come from, uniform, isotropic or cosmic, see TrackGenerator.hpp
+        //  --importance M  importance sample isotropic or cosmic tracks with biased zenith power M, 0 to switch it off
+        //  --tail N        also print the probability of a track making at least N hits
+        //  --cache DIR     directory of the result store, or none to switch it off
+        //  --checkpoint F  file to save progress in while the run goes on, or none to switch it off
+        //  --every N       number of tracks between checkpoints
+        //  --shard I       simulate only shard I of the run (0 ... shards - 1), to share it between processes
+        //  --shards N      number of shards the run is split into
+        //  --output F      file the result of a shard is written to, for MergeShards
+        //  --events F      file to write every track and the pixels it hit to, see EventOutput.hpp
+        //  --threads N     number of simulation threads, 0 for one per core
+        //  --clusters on   also group the hits of each track into clusters of neighbouring sensors, see Clustering.hpp
+        //  --reconstruct on    also fit a line to the hits of each track and compare it with the track, see Reconstruction.hpp
+        //  --multiplicity M    simulate events of several tracks, M is fixed, poisson or bundle, see EventModel.hpp
+        //  --per-event N   number of tracks in each event for fixed, mean number for poisson and bundle (up to 64)
+        //  --spread A, --radius R      rms angle (radians) and radius of the tracks of a bundle around its core
+        //  --find on       also look for the tracks of each event with the Hough finder, see HoughFinder.hpp
+        //  --digitise on   turn the hits into charges, keep those over threshold and add noise hits, see Digitisation.hpp
+        //  --threshold T, --noise P    threshold in most probable charges and chance of a noise hit in each pixel
+        long long runs{1000000};
+        std::uint64_t seed{1};
+        TrackSource source{TrackSource::uniform};
+        ImportanceSettings importance{};
+        bool useImportance{false};
+        int tailHits{0};
+        std::string cacheDirectory{"results"};
+        std::string checkpointFile{""};
+        long long checkpointEvery{100000};
+        long long shard{0};
+        long long shards{1};
+        std::string outputFile{""};
+        std::string eventFile{""};
+        int threads{1};
+        bool findClusters{false};
+        bool reconstruct{false};
+        EventSettings eventSettings{};
+        bool eventMode{false};
+        bool findTracks{false};
+        DigitisationSettings digitisation{};
+        bool digitise{false};
+        for(int i{1}; i < argc; i += 2)
+        {
+            std::string option{argv[i]};
+            if(i + 1 >= argc) {std::cout << "No value given for " << option << '\n'; return 1;}
+            if(option == "--pixel-width") {pixelWidth = std::stod(argv[i + 1]);}
+            else if(option == "--pixel-height") {pixelHeight = std::stod(argv[i + 1]);}
+            else if(option == "--pixel-depth") {pixelDepth = std::stod(argv[i + 1]);}
+            else if(option == "--sensors") {sqrtSensorNo = std::stoi(argv[i + 1]);}
+            else if(option == "--runs") {runs = std::stoll(argv[i + 1]);}
+            else if(option == "--seed") {seed = std::stoull(argv[i + 1]);}
+            else if(option == "--tracks")
+            {
+                if(!parseTrackSource(argv[i + 1], source)) {std::cout << "Unknown track source " << argv[i + 1] << '\n'; return 1;}
+            }
+            else if(option == "--importance")
+            {
+                importance.power = std::stod(argv[i + 1]);
+                useImportance = importance.power > 0;
+            }
+            else if(option == "--tail") {tailHits = std::stoi(argv[i + 1]);}
+            else if(option == "--cache") {cacheDirectory = argv[i + 1];}
+            else if(option == "--checkpoint") {checkpointFile = argv[i + 1];}
+            else if(option == "--every") {checkpointEvery = std::max(1LL, std::stoll(argv[i + 1]));}
+            else if(option == "--shard") {shard = std::stoll(argv[i + 1]);}
+            else if(option == "--shards") {shards = std::stoll(argv[i + 1]);}
+            else if(option == "--output") {outputFile = argv[i + 1];}
+            else if(option == "--events") {eventFile = argv[i + 1];}
+            else if(option == "--threads") {threads = std::stoi(argv[i + 1]);}
+            else if(option == "--clusters") {findClusters = std::string(argv[i + 1]) == "on";}
+            else if(option == "--reconstruct") {reconstruct = std::string(argv[i + 1]) == "on";}
+            else if(option == "--multiplicity")
+            {
+                if(!parseMultiplicity(argv[i + 1], eventSettings.multiplicity)) {std::cout << "Unknown multiplicity " << argv[i + 1] << '\n'; return 1;}
+                eventMode = true;
+            }
+            else if(option == "--per-event") {eventSettings.tracks = std::stod(argv[i + 1]);}
+            else if(option == "--spread") {eventSettings.spread = std::stod(argv[i + 1]);}
+            else if(option == "--radius") {eventSettings.radius = std::stod(argv[i + 1]);}
+            else if(option == "--find") {findTracks = std::string(argv[i + 1]) == "on";}
+            else if(option == "--digitise") {digitise = std::string(argv[i + 1]) == "on";}
+            else if(option == "--threshold") {digitisation.threshold = std::stod(argv[i + 1]);}
+            else if(option == "--noise") {digitisation.noise = std::stod(argv[i + 1]);}
+            else {std::cout << "Unknown option " << option << '\n'; return 1;}
+        }
+        if(shards < 1 || shard < 0 || shard >= shards) {std::cout << "Shard must be from 0 to shards - 1\n"; return 1;}
+        if(useImportance && source == TrackSource::uniform) {std::cout << "Importance sampling needs isotropic or cosmic tracks\n"; return 1;}
+        if(threads <= 0) {threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));}
+        //the finder works on events, of one track each unless --multiplicity says otherwise
+        eventMode = eventMode || findTracks;
+        bool bundles{eventSettings.multiplicity == Multiplicity::bundle};
+        if(eventMode && (useImportance || !eventFile.empty()))
+        {
+            std::cout << "--multiplicity and --find cannot be used with --importance or --events, which are for one track at a time\n";
+            return 1;
+        }
+        if(eventMode && (eventSettings.tracks < (bundles ? 1 : 0) || eventSettings.tracks > maxEventTracks
+                         || (eventSettings.multiplicity == Multiplicity::fixed && eventSettings.tracks != std::floor(eventSettings.tracks))))
+        {
+            std::cout << "Events can have up to " << maxEventTracks << " tracks, a whole number of them for fixed and at least 1 for bundle\n";
+            return 1;
+        }
+        if(digitisation.noise < 0 || digitisation.noise >= 1) {std::cout << "The noise must be from 0 to below 1\n"; return 1;}
+        if(eventMode && bundles && source == TrackSource::uniform) {std::cout << "Bundles need isotropic or cosmic tracks\n"; return 1;}
+
+        sensorWidth = 0.236 * sqrtSensorNo;
+        sensorDepth = 0.236 * sqrtSensorNo;
         createCoords(pixels, len, pixelWidth, pixelHeight, pixelDepth);
+        //in events of several tracks the statistics are of the hits of each event, the pixels hit by any of its tracks
+
+        //each shard takes its own block of track numbers, and so its own random numbers, blocks differ in size by 1 at most
+        bool sharded{shards > 1};
+        long long firstTrack{runs / shards * shard + std::min(shard, runs % shards)};
+        long long lastTrack{firstTrack + runs / shards + (shard < runs % shards ? 1 : 0)};
+        std::string shardName{sharded ? ".shard" + std::to_string(shard) : ""};
+        if(checkpointFile.empty()) {checkpointFile = "Finalised3DCuboidSImulation" + shardName + ".ckpt";}
+        if(outputFile.empty()) {outputFile = "Finalised3DCuboidSImulation" + shardName + ".txt";}
+
+        //everything that decides the result, in a fixed order and at full precision, used to look it up in the store
+        std::ostringstream key{};
+        key << std::setprecision(17) << "simulator=Finalised3DCuboidSImulation;version=" << simulatorVersion
+            << ";len=" << len << ";pixelWidth=" << pixelWidth << ";pixelHeight=" << pixelHeight << ";pixelDepth=" << pixelDepth
+            << ";sensorWidth=" << sensorWidth << ";sensorDepth=" << sensorDepth << ";sensorHeight=" << sensorHeight
+            << ";tracks=" << trackSourceName(source);
+        if(useImportance)
+        {
+            key << ";importance=" << importance.power << ',' << importance.directionShare << ',' << importance.columnShare;
+        }
+        if(eventMode)
+        {
+            key << ";multiplicity=" << multiplicityName(eventSettings.multiplicity) << ',' << eventSettings.tracks;
+            if(bundles) {key << ',' << eventSettings.spread << ',' << eventSettings.radius;}
+        }
+        if(digitise)
+        {
+            key << ";digitise=" << digitisation.threshold << ',' << digitisation.thresholdSpread << ',' << digitisation.gainSpread
+                << ',' << digitisation.width << ',' << digitisation.noise;
+        }
+        key << ";seed=" << seed;
+
+        //uniform tracks start in the middle 80% of the detector, the others cross the box around all of the sensors
+        const Box start{{0.1 * len * pixelWidth, 0.1 * len * pixelHeight, 0.1 * len * pixelDepth},
+                        {0.9 * len * pixelWidth, 0.9 * len * pixelHeight, 0.9 * len * pixelDepth}};
+        const Box detector{{-sensorWidth, -sensorHeight, -sensorDepth},
+                           {(len - 0.5) * pixelWidth + sensorWidth, (len - 0.5) * pixelHeight + sensorHeight,
+                            (len - 1) * pixelDepth + sensorDepth}};
+
+        //importance sampled tracks are aimed at the stacks of sensors, the even layers and the offset odd layers
+        SensorColumns columns{};
+        columns.halfWidth = sensorWidth;
+        columns.halfDepth = sensorDepth;
+        columns.height = 0.5 * (detector.lower[1] + detector.upper[1]);
+        for(int z{0}; z < len; ++z)
+        {
+            for(int x{0}; x < len; ++x) {columns.centres.push_back({(x + 0.5 * (z % 2)) * pixelWidth, z * pixelDepth});}
+        }
 
+        //every track is written out as an event, so a run with events simulates all of its tracks, as do runs that look
+        //at the hits of each track
+        bool writeEvents{!eventFile.empty()};
+        bool analyseTracks{writeEvents || findClusters || reconstruct || eventMode};
+
+        //tracks that are already in the store are not simulated again, only the extra ones are added to them. The store
+        //only holds whole runs starting from track 0, so a shard leaves it to MergeShards
+        bool useCache{cacheDirectory != "none" && !sharded && !analyseTracks};
+        RunStatistics stats{};
+        if(useCache) {loadResult(cacheDirectory, key.str(), stats);}
+        long long cachedRuns{stats.count};
+        long long nextTrack{firstTrack + stats.count};
+        //the store is never cut back, so a shorter run than the stored one reports the stored result, and says so
+        if(cachedRuns > runs)
+        {
+            std::cout << "The store already holds " << cachedRuns << " tracks for this design point, more than the " << runs
+                      << " asked for, the result below uses all " << cachedRuns << '\n';
+        }
 
-        double totalHits{0};
-        double runs{1000000};
-        for(int p{0}; p < runs; ++p)
+        //a killed run carries on from its last checkpoint, if that got further than the store
+        bool useCheckpoint{checkpointFile != "none" && !analyseTracks};
+        std::string checkpointKey{key.str() + (sharded ? ";first=" + std::to_string(firstTrack) : "")};
+        RunStatistics resumed{};
+        long long resumedTrack{0};
+        if(useCheckpoint && readCheckpoint(checkpointFile, checkpointKey, seed, resumedTrack, resumed) && resumedTrack > nextTrack)
         {
+            stats = resumed;
+            nextTrack = resumedTrack;
+        }
+
+        //the tracks are simulated in blocks, in rounds of one block for each thread, and the statistics of the blocks are
+        //merged in order so that the result does not depend on the number of threads
+        const long long blockSize{16384};
+        AsyncEventWriter events{};
+        if(writeEvents && !events.open(eventFile, true, threads, nextTrack, lastTrack, blockSize))
+        {
+            std::cout << "Could not write " << eventFile << '\n';
+            return 1;
+        }
+
+        //clusters per track and hits per cluster
+        RunStatistics clusterStats{};
+        RunStatistics clusterSizeStats{};
+        //events with more hits than the clustering arena holds, only their first hits are clustered
+        long long truncatedEvents{0};
+        const std::array<double, dim> spacing{pixelWidth, pixelHeight, pixelDepth};
+        auto neighbours = [&](int first, int second) {return latticeNeighbours(pixels, first, second, spacing);};
+
+        //fits are compared with the true tracks on the plane across the middle of the detector
+        ResolutionStatistics resolution{};
+        //occupancy of the events and the Hough finder's search for their tracks
+        PileUpStatistics pileUp{};
+        //the pixels' gains and thresholds are spread from the run seed, the same way for every shard and thread. The
+        //Landau table takes a while to fill, so the digitiser is only made for runs that digitise
+        std::optional<Digitiser> digitiser{};
+        if(digitise) {digitiser.emplace(volume, digitisation, seed);}
+        DigitisationStatistics digitised{};
+        HoughSettings hough{};
+        FindingStatistics finding{};
+
+        auto simulateBlock = [&](int thread, long long first, long long last, RunStatistics& blockStats,
+                                 RunStatistics& blockClusters, RunStatistics& blockClusterSizes, ResolutionStatistics& blockResolution,
+                                 PileUpStatistics& blockPileUp, FindingStatistics& blockFinding, DigitisationStatistics& blockDigitised,
+                                 long long& blockTruncated)
+        {
+            std::vector<int> hitPixels{};
+            hitPixels.reserve(2 * len);
+            //a track hits at most one sensor on each of the 2 * len planes
+            ClusterArena<maxEventTracks * 2 * len> arena{};
+            LineFitter<256> fitter{columns.height};
+            HoughFinder finder{detector, columns.height, pixelWidth, pixelDepth, hough};
+            std::vector<Track> eventTracks{};
+            std::vector<std::pair<int, std::uint64_t>> eventPixels{};
+            std::vector<std::uint64_t> eventOwners{};
+            std::vector<int> trackHits{};
+            std::vector<int> trackPixels{};
+            std::vector<double> pathRatios{};
+            std::array<std::array<double, maxEventTracks>, len * 4> interceptX{};
+            std::array<std::array<double, maxEventTracks>, len * 4> interceptZ{};
+            for(long long p{first}; p < last; ++p)
+            {
+                SplitMix64 gen{trackEngine(seed, p)};
+
+                if(!eventMode)
+                {
+                    Track track{useImportance ? importanceTrack(detector, source == TrackSource::cosmic ? 2 : 0, columns, importance, gen)
+                                              : generateTrack(source, start, detector, gen)};
+
+
+                    Array2d<double, 2, len * 4> planeIntercepts{};
+
+                    getIntercepts(planeIntercepts, len, pixelHeight, sensorHeight, track.x1, track.y1, track.z1, track.a, track.b, track.c);
+                
+                
+                
+                    int numberOfHits{getHits(pixels, planeIntercepts, len, sensorWidth, sensorDepth, hitPixels)};
+                    //the sensors are all flat, so the path through each of them is the thickness over the track's cos(theta)
+                    double pathRatio{std::sqrt(track.a * track.a + track.b * track.b + track.c * track.c) / std::abs(track.b)};
+                    if(digitise)
+                    {
+                        eventOwners.assign(hitPixels.size(), 1);
+                        pathRatios.assign(1, pathRatio);
+                        digitiser->digitise(hitPixels, eventOwners, pathRatios, gen, blockDigitised);
+                        numberOfHits = static_cast<int>(hitPixels.size());
+                    }
+                    if(useImportance) {blockStats.add(numberOfHits, track.weight);}
+                    else {blockStats.add(numberOfHits);}
+
+                    if(findClusters)
+                    {
+                        int clusters{arena.cluster(hitPixels, neighbours)};
+                        blockClusters.add(clusters, track.weight);
+                        for(int c{0}; c < clusters; ++c) {blockClusterSizes.add(arena.clusterSize(c), track.weight);}
+                    }
+
+                    if(reconstruct) {fitter.add(track, hitPixels, pixels, track.weight, blockResolution);}
+
+                    if(writeEvents) {events.push(thread, p, track, hitPixels, static_cast<float>(2 * sensorHeight * pathRatio));}
+                    continue;
+                }
 
-            double x1 {randomNumber(0.9 * len * pixelWidth, 0.1 * len * pixelWidth)};
-            double y1 {randomNumber(0.9 * len * pixelHeight, 0.1 * len * pixelHeight)};
-            double z1 {randomNumber(0.9 * len * pixelDepth, 0.1 * len * pixelDepth)};
-            double a {randomNumber(100, -100)};
-            double b {randomNumber(100, -100)};
-            double c {randomNumber(100, -100)};
+                //all of the tracks of the event are intersected with the detector together, and a pixel hit by several
+                //of them fires once
+                generateEvent(eventSettings, source, start, detector, gen, eventTracks);
+                int tracksInEvent{static_cast<int>(eventTracks.size())};
+                getEventIntercepts(interceptX, interceptZ, len, pixelHeight, sensorHeight, eventTracks);
+                int numberOfHits{getEventHits(pixels, interceptX, interceptZ, tracksInEvent, len, pixelWidth, pixelDepth, sensorWidth,
+                                              sensorDepth, eventPixels, hitPixels, eventOwners, trackHits)};
+                if(digitise)
+                {
+                    pathRatios.clear();
+                    for(const Track& track : eventTracks)
+                    {
+                        pathRatios.push_back(std::sqrt(track.a * track.a + track.b * track.b + track.c * track.c) / std::abs(track.b));
+                    }
+                    digitiser->digitise(hitPixels, eventOwners, pathRatios, gen, blockDigitised);
+                    numberOfHits = static_cast<int>(hitPixels.size());
+                    //a track is only findable from the hits it left that fired
+                    trackHits.assign(tracksInEvent, 0);
+                    for(std::uint64_t owner : eventOwners)
+                    {
+                        for(int k{0}; k < tracksInEvent; ++k) {trackHits[k] += (owner >> k) & 1;}
+                    }
+                }
+                blockStats.add(numberOfHits);
+                //with digitisation the occupancy includes the noise hits
+                blockPileUp.add(eventOwners, trackHits);
+
+                //the clusters of an event are those of all its hits, as the detector would see them
+                if(findClusters)
+                {
+                    int clusters{arena.cluster(hitPixels, neighbours)};
+                    blockClusters.add(clusters);
+                    for(int c{0}; c < clusters; ++c) {blockClusterSizes.add(arena.clusterSize(c));}
+                }
+
+                //each track is fitted to the hits it made, shared hits included
+                if(reconstruct)
+                {
+                    for(int k{0}; k < tracksInEvent; ++k)
+                    {
+                        trackPixels.clear();
+                        for(std::size_t h{0}; h < hitPixels.size(); ++h)
+                        {
+                            if((eventOwners[h] >> k) & 1) {trackPixels.push_back(hitPixels[h]);}
+                        }
+                        fitter.add(eventTracks[k], trackPixels, pixels, 1, blockResolution);
+                    }
+                }
 
+                if(findTracks) {blockFinding.add(finder.find(hitPixels, pixels), eventOwners, trackHits, hough.minHits);}
+            }
+            fitter.flush(blockResolution);
+            blockTruncated = arena.truncatedEvents();
+        };
+
+        long long checkpointed{stats.count};
+        for(long long round{nextTrack}; round < lastTrack; round += threads * blockSize)
+        {
+            std::vector<RunStatistics> blockStats(threads);
+            std::vector<RunStatistics> blockClusters(threads);
+            std::vector<RunStatistics> blockClusterSizes(threads);
+            std::vector<ResolutionStatistics> blockResolution(threads);
+            std::vector<PileUpStatistics> blockPileUp(threads);
+            std::vector<FindingStatistics> blockFinding(threads);
+            std::vector<DigitisationStatistics> blockDigitised(threads);
+            std::vector<long long> blockTruncated(threads, 0);
+            std::vector<std::thread> workers{};
+            for(int t{0}; t < threads; ++t)
+            {
+                long long first{std::min(lastTrack, round + t * blockSize)};
+                workers.emplace_back(simulateBlock, t, first, std::min(lastTrack, first + blockSize), std::ref(blockStats[t]),
+                                     std::ref(blockClusters[t]), std::ref(blockClusterSizes[t]), std::ref(blockResolution[t]),
+                                     std::ref(blockPileUp[t]), std::ref(blockFinding[t]), std::ref(blockDigitised[t]),
+                                     std::ref(blockTruncated[t]));
+            }
+            for(std::thread& worker : workers) {worker.join();}
+            for(int t{0}; t < threads; ++t)
+            {
+                stats.merge(blockStats[t]);
+                clusterStats.merge(blockClusters[t]);
+                clusterSizeStats.merge(blockClusterSizes[t]);
+                resolution.merge(blockResolution[t]);
+                pileUp.merge(blockPileUp[t]);
+                finding.merge(blockFinding[t]);
+                digitised.merge(blockDigitised[t]);
+                truncatedEvents += blockTruncated[t];
+            }
 
-            Array2d<double, 2, len * 4> planeIntercepts{};
+            if(useCheckpoint && stats.count / checkpointEvery > checkpointed / checkpointEvery)
+            {
+                writeCheckpoint(checkpointFile, checkpointKey, seed, std::min(lastTrack, round + threads * blockSize), stats);
+                checkpointed = stats.count;
+            }
+        }
 
-            getIntercepts(planeIntercepts, len, pixelHeight, sensorHeight, x1, y1, z1, a, b, c);
-            
-            
-            
-            int numberOfHits{getHits(pixels, planeIntercepts, len, sensorWidth, sensorDepth)};
-            totalHits += numberOfHits;
+        if(writeEvents && !events.close()) {std::cout << "Could not write " << eventFile << '\n'; return 1;}
+        if(useCache && stats.count > cachedRuns) {storeResult(cacheDirectory, key.str(), stats);}
+        if(sharded && !writeShardResult(outputFile, ShardResult{key.str(), firstTrack, lastTrack, runs, stats}))
+        {
+            std::cout << "Could not write " << outputFile << '\n';
+            return 1;
         }
+        //the run is finished so its checkpoint is not needed any more
+        if(useCheckpoint) {std::filesystem::remove(checkpointFile);}
         //std::cout << "Number of sensors: " << sensorNo << '\n';
         //std::cout << "Total hits: " << totalHits << '\n';
         //std::cout << "Average hits: " << static_cast<double>(totalHits) /static_cast<double>(runs) << '\n' << "\n\n\n";
     
-        std::cout << totalHits / runs << ", ";
+        std::cout << stats.mean() << ", ";
+        if(tailHits > 0)
+        {
+            std::cout << "\nP(hits >= " << tailHits << ") = " << stats.tailProbability(tailHits) << " +- "
+                      << stats.tailError(tailHits) << ", effective tracks: " << stats.effectiveCount() << '\n';
+        }
+        //the clusters only cover the tracks simulated in this run, not those from the store or a checkpoint
+        if(findClusters)
+        {
+            std::cout << "\nClusters per " << (eventMode ? "event: " : "track: ") << clusterStats.mean() << " +- " << clusterStats.error()
+                      << ", hits per cluster: " << clusterSizeStats.mean() << " +- " << clusterSizeStats.error() << '\n';
+            std::cout << "Cluster sizes:";
+            for(int size{1}; size < static_cast<int>(clusterSizeStats.histogram.size()); ++size)
+            {
+                std::cout << ' ' << size << ':' << clusterSizeStats.histogram[size];
+            }
+            std::cout << '\n';
+            std::cout << "Truncated " << (eventMode ? "events" : "tracks") << ": " << truncatedEvents
+                      << ", with more hits than the clustering holds, only their first hits were clustered\n";
+        }
+        if(reconstruct)
+        {
+            std::cout << "\nFitted tracks: " << resolution.fitted / (resolution.fitted + resolution.unfitted)
+                      << " of all tracks (the rest have hits at fewer than 2 heights)\n";
+            std::cout << "Angle to the true track (mrad): median " << resolution.angle.quantile(0.5) << ", 68% below "
+                      << resolution.angle.quantile(0.68) << ", 95% below " << resolution.angle.quantile(0.95) << '\n';
+            std::cout << "Residual on the middle plane, x: mean " << resolution.residualX.mean() << ", rms "
+                      << resolution.residualX.rms() << "; z: mean " << resolution.residualZ.mean() << ", rms "
+                      << resolution.residualZ.rms() << '\n';
+        }
+        //like the clusters, only the tracks simulated in this run
+        if(digitise)
+        {
+            std::cout << "\nDigitisation, threshold " << digitisation.threshold << ", noise " << digitisation.noise << ": "
+                      << digitised.efficiency() << " of the pixels crossed by a track fired, " << digitised.noisePerEvent()
+                      << " noise hits per " << (eventMode ? "event" : "track") << '\n';
+        }
+        if(eventMode)
+        {
+            std::cout << "\nEvents, " << multiplicityName(eventSettings.multiplicity) << " with " << eventSettings.tracks
+                      << " tracks: tracks per event " << static_cast<double>(pileUp.tracks) / pileUp.events
+                      << ", hits of the tracks per event " << static_cast<double>(pileUp.trackHits) / pileUp.events
+                      << ", hit pixels per event " << static_cast<double>(pileUp.hits) / pileUp.events << '\n';
+            std::cout << "Occupancy " << pileUp.occupancy(volume) << " of the " << volume << " sensors, "
+                      << pileUp.sharedFraction() << " of the hit pixels were hit by 2 or more tracks\n";
+        }
+        if(findTracks)
+        {
+            std::cout << "\nTrack finding, layout " << pixelWidth << " x " << pixelHeight << " x " << pixelDepth << ", "
+                      << sqrtSensorNo << " sensors a side: efficiency " << finding.efficiency() << " (" << finding.found
+                      << " of " << finding.findable << " tracks with " << hough.minHits << " or more hits), fake rate "
+                      << finding.fakeRate() << " (" << finding.fakes << " of " << finding.candidates << " candidates)\n";
+        }
+        //waits on the event queues, many producer waits mean the run was held up by writing the events
+        if(writeEvents)
+        {
+            std::cout << "\nEvent output: simulation waited " << events.producerWaits() << " times, writer waited "
+                      << events.writerWaits() << " times, " << events.truncated() << " events truncated\n";
+        }
        
     
     return 0;
@@ -0,0 +1,328 @@
+#ifndef HOUGH_FINDER_HPP
+#define HOUGH_FINDER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "TrackGenerator.hpp"
+
+/*
+Finding the tracks of an event with several tracks by a Hough transform. A straight line is
+
+        x = x0 + slopeX * u,    z = z0 + slopeZ * u,    with u = y - reference
+
+so each projection onto a vertical plane is a line in (u, x) or (u, z). Every hit votes, for each slope of a range of
+slopes, for the intercept of the line through it, and the hits of one track all vote for the same (slope, intercept)
+cell. The finder
+
+        votes all hits into the (slopeX, x0) accumulator, and takes its peaks from the most votes down
+        votes the unused hits near each peak's line into a (slopeZ, z0) accumulator and takes its best peak
+        keeps the candidate if it still has enough hits at 2 or more heights, and marks its hits as used
+
+A hit votes for the 2 intercept cells nearest its intercept, so each cell counts the hits within one cell of its
+centre and a track is never split between 2 cells. Peaks are the cells with more votes than their 8 neighbours (non
+maximum suppression), and the used hits stop one track being found twice from neighbouring peaks.
+
+The accumulator is a row of intercept cells for each slope, and the votes are cast a block of rows at a time, so the
+block stays in the L1 cache while every hit votes into it. For each hit the cells of a whole block are worked out in one
+loop over arrays with no branches, which the compiler vectorises, before the cells are counted.
+*/
+
+struct HoughSettings
+{
+    double maxSlope{3};     //largest |slope| searched, steeper tracks are not found
+    int minHits{3};         //fewest hits on a track candidate
+};
+
+//a (slope, intercept) accumulator for one projection
+class HoughPlane
+{
+public:
+    HoughPlane(double maxSlope, double slopeBin, double lower, double upper, double interceptBin)
+        : fLower{lower}, fInterceptBin{interceptBin}
+    {
+        fRows = std::max(1, static_cast<int>(std::ceil(2 * maxSlope / slopeBin)));
+        fColumns = std::max(1, static_cast<int>(std::ceil((upper - lower) / interceptBin)));
+        fSlopes.resize(fRows);
+        for(int row{0}; row < fRows; ++row) {fSlopes[row] = -maxSlope + (row + 0.5) * 2 * maxSlope / fRows;}
+        fCells.assign(static_cast<std::size_t>(fRows) * fColumns, 0);
+    }
+
+    double slope(int row) const {return fSlopes[row];}
+    double intercept(int column) const {return fLower + (column + 0.5) * fInterceptBin;}
+    double interceptBin() const {return fInterceptBin;}
+
+    //casts the votes of the points (u[i], v[i]) for the listed i, after clearing the old votes
+    void vote(const std::vector<double>& u, const std::vector<double>& v, const std::vector<int>& points)
+    {
+        std::fill(fCells.begin(), fCells.end(), 0);
+        std::array<int, blockRows> nearest{};
+        std::array<int, blockRows> second{};
+        for(int first{0}; first < fRows; first += blockRows)
+        {
+            int rows{std::min(blockRows, fRows - first)};
+            const double* slopes{fSlopes.data() + first};
+            std::uint16_t* block{fCells.data() + static_cast<std::size_t>(first) * fColumns};
+            for(int point : points)
+            {
+                double pointU{u[point]};
+                double position{(v[point] - fLower) / fInterceptBin - 0.5};
+                for(int row{0}; row < rows; ++row)
+                {
+                    double cell{position - slopes[row] * pointU / fInterceptBin};
+                    double lowerCell{std::floor(cell)};
+                    nearest[row] = static_cast<int>(lowerCell);
+                    second[row] = nearest[row] + 1;
+                }
+                for(int row{0}; row < rows; ++row)
+                {
+                    std::uint16_t* cells{block + static_cast<std::size_t>(row) * fColumns};
+                    if(nearest[row] >= 0 && nearest[row] < fColumns) {++cells[nearest[row]];}
+                    if(second[row] >= 0 && second[row] < fColumns) {++cells[second[row]];}
+                }
+            }
+        }
+    }
+
+    /*
+    This function finds the peaks of the accumulator, the cells with at least threshold votes and more than their
+    neighbours, ties going to the first cell
+
+    inputs:
+            threshold: int, the fewest votes of a peak
+            peaks: vector called by reference, filled with (votes, row, column) from the most votes down
+    */
+
+    void findPeaks(int threshold, std::vector<std::array<int, 3>>& peaks) const
+    {
+        peaks.clear();
+        for(int row{0}; row < fRows; ++row)
+        {
+            for(int column{0}; column < fColumns; ++column)
+            {
+                int votes{cell(row, column)};
+                if(votes < threshold) {continue;}
+                bool peak{true};
+                for(int dr{-1}; dr <= 1 && peak; ++dr)
+                {
+                    for(int dc{-1}; dc <= 1 && peak; ++dc)
+                    {
+                        if(dr == 0 && dc == 0) {continue;}
+                        int neighbour{cell(row + dr, column + dc)};
+                        //a neighbour with equal votes only wins if it comes first
+                        bool before{dr < 0 || (dr == 0 && dc < 0)};
+                        if(neighbour > votes || (neighbour == votes && before)) {peak = false;}
+                    }
+                }
+                if(peak) {peaks.push_back({votes, row, column});}
+            }
+        }
+        std::sort(peaks.begin(), peaks.end(), [](const std::array<int, 3>& left, const std::array<int, 3>& right)
+                  {return left[0] > right[0] || (left[0] == right[0] && (left[1] < right[1] || (left[1] == right[1] && left[2] < right[2])));});
+    }
+
+private:
+    static constexpr int blockRows{16};
+
+    int cell(int row, int column) const
+    {
+        if(row < 0 || row >= fRows || column < 0 || column >= fColumns) {return 0;}
+        return fCells[static_cast<std::size_t>(row) * fColumns + column];
+    }
+
+    double fLower{0};
+    double fInterceptBin{1};
+    int fRows{1};
+    int fColumns{1};
+    std::vector<double> fSlopes{};
+    std::vector<std::uint16_t> fCells{};
+};
+
+struct TrackCandidate
+{
+    double x0, slopeX, z0, slopeZ;
+    std::vector<int> hits;      //positions of the candidate's hits in the event's hit list
+};
+
+class HoughFinder
+{
+public:
+    /*
+    inputs:
+            detector: Box, a box around all of the sensors
+            reference: double, the height u is measured from, usually the middle of the detector
+            pixelWidth, pixelDepth: double, the pixel sizes in x and z, the intercept cells are half a pixel wide in x
+                    (the offset layers are half a pixel along) and a pixel deep in z
+            settings: HoughSettings
+    */
+
+    HoughFinder(const Box& detector, double reference, double pixelWidth, double pixelDepth, const HoughSettings& settings)
+        : fReference{reference}, fSettings{settings},
+          fPlaneX{settings.maxSlope, 0.5 * pixelWidth / halfHeight(detector, reference),
+                  detector.lower[0] - settings.maxSlope * halfHeight(detector, reference),
+                  detector.upper[0] + settings.maxSlope * halfHeight(detector, reference), 0.5 * pixelWidth},
+          fPlaneZ{settings.maxSlope, pixelDepth / halfHeight(detector, reference),
+                  detector.lower[2] - settings.maxSlope * halfHeight(detector, reference),
+                  detector.upper[2] + settings.maxSlope * halfHeight(detector, reference), pixelDepth}
+    {}
+
+    /*
+    This function finds the tracks of an event
+
+    inputs:
+            hits: the ids of the hit pixels, each once
+            pixels: the coordinates of the pixel centres, as filled in by createCoords
+
+    outputs:
+            the track candidates, valid until the next call
+    */
+
+    template <typename Pixels>
+    const std::vector<TrackCandidate>& find(const std::vector<int>& hits, const Pixels& pixels)
+    {
+        fCandidates.clear();
+        std::size_t count{hits.size()};
+        fU.resize(count);
+        fX.resize(count);
+        fZ.resize(count);
+        fUsed.assign(count, false);
+        fAll.resize(count);
+        for(std::size_t i{0}; i < count; ++i)
+        {
+            fU[i] = pixels[hits[i]][1] - fReference;
+            fX[i] = pixels[hits[i]][0];
+            fZ[i] = pixels[hits[i]][2];
+            fAll[i] = static_cast<int>(i);
+        }
+        if(static_cast<int>(count) < fSettings.minHits) {return fCandidates;}
+
+        fPlaneX.vote(fU, fX, fAll);
+        fPlaneX.findPeaks(fSettings.minHits, fPeaksX);
+        for(const std::array<int, 3>& peakX : fPeaksX)
+        {
+            double slopeX{fPlaneX.slope(peakX[1])};
+            double x0{fPlaneX.intercept(peakX[2])};
+            nearLine(fX, slopeX, x0, fPlaneX.interceptBin(), fAll, fNearX);
+            if(static_cast<int>(fNearX.size()) < fSettings.minHits) {continue;}
+
+            fPlaneZ.vote(fU, fZ, fNearX);
+            fPlaneZ.findPeaks(fSettings.minHits, fPeaksZ);
+            if(fPeaksZ.empty()) {continue;}
+            double slopeZ{fPlaneZ.slope(fPeaksZ[0][1])};
+            double z0{fPlaneZ.intercept(fPeaksZ[0][2])};
+            nearLine(fZ, slopeZ, z0, fPlaneZ.interceptBin(), fNearX, fNear);
+            if(static_cast<int>(fNear.size()) < fSettings.minHits) {continue;}
+
+            //a line needs hits at 2 or more heights
+            bool heights{false};
+            for(int hit : fNear) {heights = heights || fU[hit] != fU[fNear[0]];}
+            if(!heights) {continue;}
+
+            for(int hit : fNear) {fUsed[hit] = true;}
+            fCandidates.push_back({x0, slopeX, z0, slopeZ, fNear});
+        }
+        return fCandidates;
+    }
+
+private:
+    static double halfHeight(const Box& detector, double reference)
+    {
+        return std::max(reference - detector.lower[1], detector.upper[1] - reference);
+    }
+
+    //the unused points of from within one cell of the line v = v0 + slope * u
+    void nearLine(const std::vector<double>& v, double slope, double v0, double bin, const std::vector<int>& from,
+                  std::vector<int>& near) const
+    {
+        near.clear();
+        for(int point : from)
+        {
+            if(!fUsed[point] && std::abs(v[point] - (v0 + slope * fU[point])) <= bin) {near.push_back(point);}
+        }
+    }
+
+    double fReference{0};
+    HoughSettings fSettings{};
+    HoughPlane fPlaneX;
+    HoughPlane fPlaneZ;
+    std::vector<double> fU{}, fX{}, fZ{};
+    std::vector<bool> fUsed{};
+    std::vector<int> fAll{}, fNearX{}, fNear{};
+    std::vector<std::array<int, 3>> fPeaksX{}, fPeaksZ{};
+    std::vector<TrackCandidate> fCandidates{};
+};
+
+/*
+Finding efficiency and fake rate. A candidate finds a true track if at least 70% of its hits were made by that track.
+A true track is findable if it made at least minHits hits, the efficiency is the share of findable tracks found by a
+candidate and the fake rate is the share of candidates that find no track
+*/
+
+struct FindingStatistics
+{
+    long long findable{0};
+    long long found{0};
+    long long candidates{0};
+    long long fakes{0};
+
+    /*
+    This function adds the result of an event
+
+    inputs:
+            candidates: the track candidates found
+            owners: for each hit of the event, a bit for each true track that made it
+            trackHits: the number of hits of each true track
+            minHits: int, the fewest hits of a findable track
+    */
+
+    void add(const std::vector<TrackCandidate>& result, const std::vector<std::uint64_t>& owners, const std::vector<int>& trackHits,
+             int minHits)
+    {
+        std::uint64_t foundTracks{0};
+        for(const TrackCandidate& candidate : result)
+        {
+            ++candidates;
+            bool matched{false};
+            for(std::size_t track{0}; track < trackHits.size(); ++track)
+            {
+                int shared{0};
+                for(int hit : candidate.hits) {shared += (owners[hit] >> track) & 1;}
+                if(10 * shared >= 7 * static_cast<int>(candidate.hits.size()))
+                {
+                    matched = true;
+                    foundTracks |= 1ULL << track;
+                }
+            }
+            if(!matched) {++fakes;}
+        }
+        for(std::size_t track{0}; track < trackHits.size(); ++track)
+        {
+            if(trackHits[track] < minHits) {continue;}
+            ++findable;
+            if((foundTracks >> track) & 1) {++found;}
+        }
+    }
+
+    void merge(const FindingStatistics& other)
+    {
+        findable += other.findable;
+        found += other.found;
+        candidates += other.candidates;
+        fakes += other.fakes;
+    }
+
+    double efficiency() const
+    {
+        return findable > 0 ? static_cast<double>(found) / findable : 0;
+    }
+
+    double fakeRate() const
+    {
+        return candidates > 0 ? static_cast<double>(fakes) / candidates : 0;
+    }
+};
+
+#endif
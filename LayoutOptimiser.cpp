@@ -0,0 +1,219 @@
+#include <iostream>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "ExpectedHits.hpp"
+
+/*
+Optimises pixelWidth, pixelHeight, pixelDepth and sqrtSensorNo of the cuboid detector in Finalised3DCuboidSImulation.cpp
+instead of editing them by hand and re-running the simulation.
+
+The objective is the expected hits per track from ExpectedHits.hpp minus a cost for every sensor in the detector:
+
+        objective = hits per track - sensorCost * len^3 * sqrtSensorNo^2
+
+The expected hits are computed by quadrature with a fixed set of nodes, so the objective is a smooth deterministic
+function of the layout and a finite difference gradient has no sampling noise in it (the same thing common random
+numbers would give a Monte Carlo estimate, but exactly). The optimiser is projected gradient ascent on the parameters
+scaled to [0, 1] within their bounds, with Barzilai-Borwein step lengths inside a trust radius that grows after every
+successful step and shrinks on a failed one, so it usually settles in a few dozen evaluations.
+
+The sensors have to fit on the pixel, so the pixel width and depth are never allowed below the full sensor size
+(2 * 0.236 * sqrtSensorNo). sqrtSensorNo is treated as continuous and rounded at the end.
+
+usage: LayoutOptimiser [sensorCost] [len]
+*/
+
+constexpr int nParameters{4};
+using Parameters = std::array<double, nParameters>;
+
+//pixelWidth, pixelHeight, pixelDepth, sqrtSensorNo
+const Parameters lowerBounds{20, 10, 10, 1};
+const Parameters upperBounds{120, 60, 40, 60};
+const std::array<std::string, nParameters> names{"pixelWidth", "pixelHeight", "pixelDepth", "sqrtSensorNo"};
+
+const double sensorPitch{0.236};
+const double sensorHeight{6e-3};
+
+
+/*
+This function moves a set of parameters back inside the bounds, then widens the pixel if the sensor no longer fits
+
+inputs:
+        parameters: Parameters, called by reference and corrected in place
+*/
+
+void project(Parameters& parameters)
+{
+    for(int i{0}; i < nParameters; ++i)
+    {
+        parameters[i] = std::clamp(parameters[i], lowerBounds[i], upperBounds[i]);
+    }
+    double sensorSize{2 * sensorPitch * parameters[3]};
+    parameters[0] = std::max(parameters[0], sensorSize);
+    parameters[2] = std::max(parameters[2], sensorSize);
+}
+
+/*
+This function evaluates the expected hits per track for a set of parameters
+
+inputs:
+        parameters: Parameters, the layout
+        len: int, the number of pixels along each side of the detector
+
+outputs:
+        double, the expected hits per track
+*/
+
+double hitsPerTrack(const Parameters& parameters, int len)
+{
+    CuboidLayout layout{len, parameters[0], parameters[1], parameters[2],
+                        sensorPitch * parameters[3], sensorPitch * parameters[3], sensorHeight};
+    return expectedHitsCuboid(layout);
+}
+
+double objective(const Parameters& parameters, int len, double sensorCost, int& evaluations)
+{
+    ++evaluations;
+    double sensorNo{static_cast<double>(len) * len * len * parameters[3] * parameters[3]};
+    return hitsPerTrack(parameters, len) - sensorCost * sensorNo;
+}
+
+void printRow(int iteration, int evaluations, const Parameters& parameters, int len, double value)
+{
+    std::cout << iteration << '\t' << evaluations;
+    for(double p : parameters) {std::cout << '\t' << p;}
+    std::cout << '\t' << hitsPerTrack(parameters, len) << '\t' << value << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+    double sensorCost{argc > 1 ? std::stod(argv[1]) : 1e-7};
+    int len{argc > 2 ? std::stoi(argv[2]) : 14};
+
+    const int maxEvaluations{80};
+    const double tolerance{1e-5};
+    const double difference{1e-4};      //finite difference step in scaled units
+
+    //start from the layout currently in Finalised3DCuboidSImulation.cpp
+    Parameters current{80, 29, 19, 40};
+    project(current);
+
+    int evaluations{0};
+    double value{objective(current, len, sensorCost, evaluations)};
+
+    std::cout << "iteration\tevaluations";
+    for(const std::string& name : names) {std::cout << '\t' << name;}
+    std::cout << "\thits\tobjective\n";
+    printRow(0, evaluations, current, len, value);
+
+    Parameters gradient{};
+    Parameters previousPoint{};
+    Parameters previousGradient{};
+    double step{1};
+    double radius{0.1};                 //largest move of any scaled parameter in one step
+
+    for(int iteration{1}; evaluations < maxEvaluations; ++iteration)
+    {
+        //forward differences in scaled units, stepping inwards at an upper bound
+        for(int i{0}; i < nParameters; ++i)
+        {
+            double scale{upperBounds[i] - lowerBounds[i]};
+            double sign{current[i] + difference * scale > upperBounds[i] ? -1.0 : 1.0};
+            Parameters shifted{current};
+            shifted[i] += sign * difference * scale;
+            gradient[i] = sign * (objective(shifted, len, sensorCost, evaluations) - value) / difference;
+        }
+
+        //Barzilai-Borwein step length from the change in position and gradient
+        if(iteration > 1)
+        {
+            double ss{0};
+            double sy{0};
+            for(int i{0}; i < nParameters; ++i)
+            {
+                double scale{upperBounds[i] - lowerBounds[i]};
+                double s{(current[i] - previousPoint[i]) / scale};
+                double y{gradient[i] - previousGradient[i]};
+                ss += s * s;
+                sy += s * y;
+            }
+            //ascending a concave objective gives sy < 0
+            step = (sy < 0) ? -ss / sy : 2 * step;
+        }
+
+        //the sensor count dominates the gradient far from the optimum, so a step is also kept inside the trust radius
+        double largest{0};
+        for(double g : gradient) {largest = std::max(largest, std::fabs(g));}
+        if(largest == 0) {break;}
+        step = std::min(step, radius / largest);
+
+        //take the projected step, halving it until the objective improves
+        Parameters trial{};
+        double trialValue{value};
+        bool improved{false};
+        while(evaluations < maxEvaluations)
+        {
+            for(int i{0}; i < nParameters; ++i)
+            {
+                trial[i] = current[i] + step * gradient[i] * (upperBounds[i] - lowerBounds[i]);
+            }
+            project(trial);
+
+            //nothing left to gain when every parameter that would move is held at a bound
+            double moved{0};
+            for(int i{0}; i < nParameters; ++i)
+            {
+                moved = std::max(moved, std::fabs(trial[i] - current[i]) / (upperBounds[i] - lowerBounds[i]));
+            }
+            if(moved < 1e-9) {break;}
+
+            trialValue = objective(trial, len, sensorCost, evaluations);
+            if(trialValue > value) {improved = true; break;}
+            step /= 2;
+            radius = step * largest;
+            if(radius < 1e-9) {break;}
+        }
+        if(!improved) {break;}
+
+        radius = std::min(2 * radius, 1.0);
+        previousPoint = current;
+        previousGradient = gradient;
+        double change{trialValue - value};
+        current = trial;
+        value = trialValue;
+        printRow(iteration, evaluations, current, len, value);
+
+        //the objective is measured in hits per track, so changes are compared with at least one hit
+        if(change < tolerance * std::max(1.0, std::fabs(value))) {break;}
+    }
+
+    //sqrtSensorNo has to be a whole number, try both neighbours of the continuous optimum
+    Parameters best{current};
+    double bestValue{-1e300};
+    for(double rounded : {std::floor(current[3]), std::ceil(current[3])})
+    {
+        Parameters candidate{current};
+        candidate[3] = rounded;
+        project(candidate);
+        double candidateValue{objective(candidate, len, sensorCost, evaluations)};
+        if(candidateValue > bestValue)
+        {
+            best = candidate;
+            bestValue = candidateValue;
+        }
+    }
+
+    std::cout << "\nOptimised layout after " << evaluations << " evaluations:\n";
+    for(int i{0}; i < nParameters; ++i)
+    {
+        std::cout << names[i] << ": " << best[i] << '\n';
+    }
+    std::cout << "Expected hits per track: " << hitsPerTrack(best, len) << '\n';
+    std::cout << "Number of sensors: " << static_cast<double>(len) * len * len * best[3] * best[3] << '\n';
+    std::cout << "Objective: " << bestValue << '\n';
+
+    return 0;
+}
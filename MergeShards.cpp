@@ -0,0 +1,110 @@
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ShardResult.hpp"
+#include "ResultCache.hpp"
+
+/*
+Merges the results of a run that was split into shards, see ShardResult.hpp. A run can be shared between processes on
+one machine, e.g. in bash
+
+        for i in 0 1 2 3; do ./Finalised3DCuboidSImulation --runs 4000000 --shards 4 --shard $i & done; wait
+        ./MergeShards Finalised3DCuboidSImulation.shard*.txt
+
+and gives exactly the same numbers as one process simulating all 4000000 tracks. The shards must all come from the same
+run (the same key) and must not share any tracks, missing shards are reported and the rest are still merged. If the
+shards cover every track from 0 up, --cache DIR saves the merged result in the result store so that later runs of the
+simulation can use it.
+
+usage: MergeShards [--cache DIR] shard files...
+*/
+
+int main(int argc, char* argv[])
+{
+    std::string cacheDirectory{"none"};
+    std::vector<ShardResult> shards{};
+    for(int i{1}; i < argc; ++i)
+    {
+        std::string argument{argv[i]};
+        if(argument == "--cache" && i + 1 < argc)
+        {
+            cacheDirectory = argv[++i];
+            continue;
+        }
+        ShardResult shard{};
+        if(!readShardResult(argument, shard))
+        {
+            std::cout << "Could not read " << argument << '\n';
+            return 1;
+        }
+        shards.push_back(shard);
+    }
+    if(shards.empty())
+    {
+        std::cout << "usage: MergeShards [--cache DIR] shard files...\n";
+        return 1;
+    }
+
+    std::sort(shards.begin(), shards.end(),
+              [](const ShardResult& left, const ShardResult& right) {return left.first < right.first;});
+
+    RunStatistics total{};
+    long long covered{0};
+    long long end{0};
+    bool wholeRun{true};
+    for(const ShardResult& shard : shards)
+    {
+        if(shard.key != shards[0].key)
+        {
+            std::cout << "Shards come from different runs:\n" << shards[0].key << '\n' << shard.key << '\n';
+            return 1;
+        }
+        if(shard.total != shards[0].total)
+        {
+            std::cout << "Shards come from runs of " << shards[0].total << " and " << shard.total << " tracks\n";
+            return 1;
+        }
+        if(shard.first < end)
+        {
+            std::cout << "Shards overlap at track " << shard.first << '\n';
+            return 1;
+        }
+        if(shard.first > end) {std::cout << "Missing tracks " << end << " to " << shard.first - 1 << '\n';}
+        //a shard that was not finished only holds its first tracks
+        if(shard.stats.count < shard.last - shard.first)
+        {
+            std::cout << "Shard from track " << shard.first << " is unfinished, " << shard.stats.count << " of "
+                      << shard.last - shard.first << " tracks\n";
+        }
+        wholeRun = wholeRun && shard.first == end && shard.stats.count == shard.last - shard.first;
+        end = shard.last;
+        covered += shard.stats.count;
+        total.merge(shard.stats);
+    }
+    //the last shards are missing if the shards stop short of the whole run
+    if(end < shards[0].total) {std::cout << "Missing tracks " << end << " to " << shards[0].total - 1 << '\n';}
+    wholeRun = wholeRun && end == shards[0].total;
+
+    std::cout << "Key: " << shards[0].key << '\n';
+    std::cout << "Shards: " << shards.size() << ", tracks: " << covered << '\n';
+    std::cout << "Average hits: " << total.mean() << " +- " << total.error() << '\n';
+    if(total.weighted()) {std::cout << "Importance sampled, effective tracks: " << total.effectiveCount() << '\n';}
+    std::cout << "Hits per track:";
+    for(std::size_t hits{0}; hits < total.histogram.size(); ++hits) {std::cout << ' ' << hits << ':' << total.histogram[hits];}
+    std::cout << '\n';
+
+    if(cacheDirectory != "none")
+    {
+        RunStatistics stored{};
+        if(!wholeRun) {std::cout << "Not saved, the shards do not cover every track from 0\n";}
+        else if(loadResult(cacheDirectory, shards[0].key, stored) && stored.count >= total.count)
+        {
+            std::cout << "Not saved, the store already holds " << stored.count << " tracks\n";
+        }
+        else if(!storeResult(cacheDirectory, shards[0].key, total)) {std::cout << "Could not save to " << cacheDirectory << '\n';}
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <string>
+
+#include "EventOutput.hpp"
+#include "RunStatistics.hpp"
+
+/*
+Reads an event file written by the simulation with --events, see EventOutput.hpp. It prints the hits statistics of a
+range of events, and with --print also prints every event in the range, one per line as
+
+        event number, weight, number of hits: pixel id (path length) ...
+
+usage: ReadEvents file [first event] [last event] [--print]
+*/
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cout << "usage: ReadEvents file [first event] [last event] [--print]\n";
+        return 1;
+    }
+    bool print{std::string(argv[argc - 1]) == "--print"};
+    int numbers{argc - (print ? 3 : 2)};
+
+    EventReader reader{};
+    if(!reader.open(argv[1]))
+    {
+        std::cout << "Could not read " << argv[1] << '\n';
+        return 1;
+    }
+    long long first{numbers > 0 ? std::stoll(argv[2]) : reader.firstEvent()};
+    long long last{numbers > 1 ? std::stoll(argv[3]) : reader.lastEvent()};
+
+    RunStatistics stats{};
+    bool read{reader.forEachEvent(first, last, [&](const Event& event)
+    {
+        //unweighted events have weight 1, which gives the ordinary mean
+        stats.add(static_cast<int>(event.pixels.size()), event.track.weight);
+        if(!print) {return;}
+        std::cout << event.number << ", " << event.track.weight << ", " << event.pixels.size() << ':';
+        for(std::size_t i{0}; i < event.pixels.size(); ++i)
+        {
+            std::cout << ' ' << event.pixels[i];
+            if(reader.hasPathLengths()) {std::cout << " (" << event.pathLengths[i] << ')';}
+        }
+        std::cout << '\n';
+    })};
+    if(!read)
+    {
+        std::cout << "Could not read " << argv[1] << ", it is corrupt after " << stats.count << " events\n";
+        return 1;
+    }
+
+    std::cout << "Events " << first << " to " << last - 1 << " of " << reader.eventCount() << " in the file\n";
+    std::cout << "Average hits: " << stats.mean() << " +- " << stats.error() << '\n';
+    return 0;
+}
@@ -0,0 +1,207 @@
+#ifndef RECONSTRUCTION_HPP
+#define RECONSTRUCTION_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "TrackGenerator.hpp"
+
+/*
+Reconstruction of the straight tracks from their hits, to see how well the detector measures them. A line is fitted
+to the centres of the hit sensors by least squares, with the height y as the free variable,
+
+        x = x0 + slopeX * (y - reference),      z = z0 + slopeZ * (y - reference)
+
+and compared with the track that was generated: the angle between the two and how far apart they are where they cross
+the reference plane, usually the middle of the detector. A fit needs hits at 2 or more heights.
+
+The fits are done in batches. Each event only adds its hits to a few sums, and once a batch is full all of its fits and
+comparisons are done in one pass over arrays of the sums, with no branches, so the compiler can vectorise them.
+*/
+
+//a histogram of a double value with fixed bins, the contents are weights so importance sampled tracks can be used
+struct Histogram
+{
+    double lower{0};
+    double upper{1};
+    std::vector<double> bins{};
+    double underflow{0};
+    double overflow{0};
+    double total{0};        //total weight
+    double sum{0};          //total of weight * value
+    double sumSquares{0};   //total of weight * value squared
+
+    Histogram(double lowerEdge, double upperEdge, int binCount) : lower{lowerEdge}, upper{upperEdge}, bins(binCount, 0) {}
+
+    void add(double value, double weight)
+    {
+        total += weight;
+        sum += weight * value;
+        sumSquares += weight * value * value;
+        if(value < lower) {underflow += weight;}
+        else if(value >= upper) {overflow += weight;}
+        else {bins[static_cast<std::size_t>((value - lower) / (upper - lower) * bins.size())] += weight;}
+    }
+
+    void merge(const Histogram& other)
+    {
+        for(std::size_t i{0}; i < bins.size(); ++i) {bins[i] += other.bins[i];}
+        underflow += other.underflow;
+        overflow += other.overflow;
+        total += other.total;
+        sum += other.sum;
+        sumSquares += other.sumSquares;
+    }
+
+    double mean() const
+    {
+        return total > 0 ? sum / total : 0;
+    }
+
+    double rms() const
+    {
+        double m{mean()};
+        return total > 0 ? std::sqrt(std::max(0.0, sumSquares / total - m * m)) : 0;
+    }
+
+    //the value below which the given fraction of the weight lies, found from the bins
+    double quantile(double fraction) const
+    {
+        double wanted{fraction * total - underflow};
+        if(wanted <= 0) {return lower;}
+        double width{(upper - lower) / bins.size()};
+        for(std::size_t i{0}; i < bins.size(); ++i)
+        {
+            if(wanted <= bins[i]) {return lower + width * (i + wanted / bins[i]);}
+            wanted -= bins[i];
+        }
+        return upper;
+    }
+};
+
+struct ResolutionStatistics
+{
+    Histogram angle{0, 500, 250};           //angle between the fitted and the true track, mrad
+    Histogram residualX{-200, 200, 200};    //fitted - true x on the reference plane
+    Histogram residualZ{-200, 200, 200};    //fitted - true z on the reference plane
+    double fitted{0};                       //weight of the tracks that could be fitted
+    double unfitted{0};                     //weight of the tracks with hits at fewer than 2 heights
+
+    void merge(const ResolutionStatistics& other)
+    {
+        angle.merge(other.angle);
+        residualX.merge(other.residualX);
+        residualZ.merge(other.residualZ);
+        fitted += other.fitted;
+        unfitted += other.unfitted;
+    }
+};
+
+/*
+Fits the tracks of a batch of BatchSize events. add takes an event, and the batch is fitted and added to the
+statistics when it is full or when flush is called, flush must be called after the last event
+*/
+
+template <std::size_t BatchSize>
+class LineFitter
+{
+public:
+    explicit LineFitter(double reference) : fReference{reference} {}
+
+    /*
+    This function adds an event to the batch
+
+    inputs:
+            truth: the generated track
+            hits: the ids of the hit pixels
+            pixels: the coordinates of the pixel centres, as filled in by createCoords
+            weight: the weight of the track
+            stats: ResolutionStatistics, the batch is added to these if it is full
+    */
+
+    template <typename Pixels>
+    void add(const Track& truth, const std::vector<int>& hits, const Pixels& pixels, double weight, ResolutionStatistics& stats)
+    {
+        double n{0}, su{0}, suu{0}, sx{0}, sux{0}, sz{0}, suz{0};
+        for(int hit : hits)
+        {
+            double u{pixels[hit][1] - fReference};
+            n += 1;
+            su += u;
+            suu += u * u;
+            sx += pixels[hit][0];
+            sux += u * pixels[hit][0];
+            sz += pixels[hit][2];
+            suz += u * pixels[hit][2];
+        }
+        std::size_t i{fCount++};
+        fN[i] = n;
+        fSu[i] = su;
+        fSuu[i] = suu;
+        fSx[i] = sx;
+        fSux[i] = sux;
+        fSz[i] = sz;
+        fSuz[i] = suz;
+        //the true track where it crosses the reference plane
+        fTrueSlopeX[i] = truth.a / truth.b;
+        fTrueSlopeZ[i] = truth.c / truth.b;
+        fTrueX[i] = truth.x1 + fTrueSlopeX[i] * (fReference - truth.y1);
+        fTrueZ[i] = truth.z1 + fTrueSlopeZ[i] * (fReference - truth.y1);
+        fWeight[i] = weight;
+
+        if(fCount == BatchSize) {flush(stats);}
+    }
+
+    void flush(ResolutionStatistics& stats)
+    {
+        std::size_t count{fCount};
+        for(std::size_t i{0}; i < count; ++i)
+        {
+            double det{fN[i] * fSuu[i] - fSu[i] * fSu[i]};
+            //all hits at one height leave det zero up to rounding
+            double good{fN[i] >= 2 && det > 1e-9 * fN[i] * fSuu[i] ? 1.0 : 0.0};
+            double safeDet{good > 0 ? det : 1.0};
+            double safeN{std::max(fN[i], 1.0)};
+
+            double slopeX{(fN[i] * fSux[i] - fSu[i] * fSx[i]) / safeDet};
+            double slopeZ{(fN[i] * fSuz[i] - fSu[i] * fSz[i]) / safeDet};
+            fResidualX[i] = (fSx[i] - slopeX * fSu[i]) / safeN - fTrueX[i];
+            fResidualZ[i] = (fSz[i] - slopeZ * fSu[i]) / safeN - fTrueZ[i];
+
+            //angle between (slopeX, 1, slopeZ) and the true direction, from the sizes of their cross and dot products
+            double crossX{fTrueSlopeZ[i] - slopeZ};
+            double crossY{slopeZ * fTrueSlopeX[i] - slopeX * fTrueSlopeZ[i]};
+            double crossZ{slopeX - fTrueSlopeX[i]};
+            double dot{slopeX * fTrueSlopeX[i] + 1 + slopeZ * fTrueSlopeZ[i]};
+            fAngle[i] = 1000 * std::atan2(std::sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ), std::abs(dot));
+            fGood[i] = good;
+        }
+
+        for(std::size_t i{0}; i < count; ++i)
+        {
+            if(fGood[i] == 0)
+            {
+                stats.unfitted += fWeight[i];
+                continue;
+            }
+            stats.fitted += fWeight[i];
+            stats.angle.add(fAngle[i], fWeight[i]);
+            stats.residualX.add(fResidualX[i], fWeight[i]);
+            stats.residualZ.add(fResidualZ[i], fWeight[i]);
+        }
+        fCount = 0;
+    }
+
+private:
+    double fReference{0};
+    std::size_t fCount{0};
+    //the sums of each event, with u = y - reference
+    std::array<double, BatchSize> fN{}, fSu{}, fSuu{}, fSx{}, fSux{}, fSz{}, fSuz{};
+    std::array<double, BatchSize> fTrueX{}, fTrueZ{}, fTrueSlopeX{}, fTrueSlopeZ{}, fWeight{};
+    std::array<double, BatchSize> fResidualX{}, fResidualZ{}, fAngle{}, fGood{};
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "RunStatistics.hpp"
+
+/*
+A store of finished results on the local disk, so that a design point which has been simulated before comes back
+straight away, and asking for more tracks only simulates the extra ones.
+
+A result is found by its key, a string that lists everything that decides the tracks and hits: the simulator and its
+version, the geometry, where the tracks come from and the seed. The key is written out in a fixed order and with full
+precision by the simulation so that equal design points always give equal strings. Each result is kept in its own
+file named after a hash of the key, and the key is written at the top of the file so that a hash collision is read as
+a miss rather than as somebody else's result.
+*/
+
+//64 bit FNV-1a hash of the key, as 16 hex digits
+inline std::string keyHash(const std::string& key)
+{
+    std::uint64_t hash{0xcbf29ce484222325ULL};
+    for(unsigned char character : key)
+    {
+        hash ^= character;
+        hash *= 0x100000001b3ULL;
+    }
+    std::ostringstream hex{};
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hex.str();
+}
+
+inline std::filesystem::path resultPath(const std::string& directory, const std::string& key)
+{
+    return std::filesystem::path(directory) / (keyHash(key) + ".txt");
+}
+
+/*
+This function looks a result up in the store
+
+inputs:
+        directory: the directory of the store
+        key: the key of the design point
+        stats: RunStatistics called by reference, filled in if the result is found
+
+outputs:
+        bool, true if the result was found
+*/
+
+inline bool loadResult(const std::string& directory, const std::string& key, RunStatistics& stats)
+{
+    std::ifstream file(resultPath(directory, key));
+    std::string line{};
+    if(!file || !std::getline(file, line) || line != "key " + key) {return false;}
+    return readStatistics(file, stats);
+}
+
+/*
+This function saves a result in the store, replacing any older result with the same key. The file is written under a
+temporary name and then renamed, so a run that is killed part way through never leaves a broken result behind
+
+inputs:
+        directory: the directory of the store, it is created if needed
+        key: the key of the design point
+        stats: RunStatistics, the result
+
+outputs:
+        bool, true if the result was saved
+*/
+
+inline bool storeResult(const std::string& directory, const std::string& key, const RunStatistics& stats)
+{
+    std::error_code error{};
+    std::filesystem::create_directories(directory, error);
+
+    std::filesystem::path path{resultPath(directory, key)};
+    std::filesystem::path temporary{path};
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary);
+        if(!file) {return false;}
+        file << "key " << key << '\n';
+        writeStatistics(file, stats);
+        if(!file) {return false;}
+    }
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef RUN_STATISTICS_HPP
+#define RUN_STATISTICS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+Statistics of the number of hits per track, kept as integer totals and a histogram so that two runs over different
+tracks can be merged exactly, in any order, into the statistics of one run over all of them.
+
+Importance sampled runs (see TrackGenerator.hpp) give every track a weight. For these the total weight and the total
+squared weight of the tracks with each number of hits are kept as well, every weighted estimate can be found from
+them, and the estimates are self normalised, sum(weight * hits) / sum(weight), so the weights only have to be right up
+to a constant factor.
+*/
+
+struct RunStatistics
+{
+    long long count{0};                     //number of tracks
+    long long sum{0};                       //total hits
+    long long sumSquares{0};                //total of hits squared
+    std::vector<long long> histogram{};     //number of tracks with each number of hits
+    std::vector<double> weights{};          //total weight of the tracks with each number of hits, weighted runs only
+    std::vector<double> weightsSquared{};   //total squared weight of the tracks with each number of hits
+
+    void add(int hits)
+    {
+        ++count;
+        sum += hits;
+        sumSquares += static_cast<long long>(hits) * hits;
+        if(static_cast<std::size_t>(hits) >= histogram.size()) {histogram.resize(hits + 1, 0);}
+        ++histogram[hits];
+    }
+
+    void add(int hits, double weight)
+    {
+        add(hits);
+        if(weights.size() < histogram.size())
+        {
+            weights.resize(histogram.size(), 0);
+            weightsSquared.resize(histogram.size(), 0);
+        }
+        weights[hits] += weight;
+        weightsSquared[hits] += weight * weight;
+    }
+
+    bool weighted() const
+    {
+        return !weights.empty();
+    }
+
+    void merge(const RunStatistics& other)
+    {
+        count += other.count;
+        sum += other.sum;
+        sumSquares += other.sumSquares;
+        if(other.histogram.size() > histogram.size()) {histogram.resize(other.histogram.size(), 0);}
+        for(std::size_t i{0}; i < other.histogram.size(); ++i) {histogram[i] += other.histogram[i];}
+        if(other.weights.size() > weights.size())
+        {
+            weights.resize(other.weights.size(), 0);
+            weightsSquared.resize(other.weights.size(), 0);
+        }
+        for(std::size_t i{0}; i < other.weights.size(); ++i)
+        {
+            weights[i] += other.weights[i];
+            weightsSquared[i] += other.weightsSquared[i];
+        }
+    }
+
+    double totalWeight() const
+    {
+        double total{0};
+        for(double weight : weights) {total += weight;}
+        return total;
+    }
+
+    double mean() const
+    {
+        if(weighted())
+        {
+            double total{0};
+            for(std::size_t hits{0}; hits < weights.size(); ++hits) {total += hits * weights[hits];}
+            return total / totalWeight();
+        }
+        return count > 0 ? static_cast<double>(sum) / count : 0;
+    }
+
+    //standard error of the mean
+    double error() const
+    {
+        if(count < 2) {return 0;}
+        double m{mean()};
+        if(weighted())
+        {
+            double spread{0};
+            for(std::size_t hits{0}; hits < weights.size(); ++hits) {spread += weightsSquared[hits] * (hits - m) * (hits - m);}
+            return std::sqrt(spread) / totalWeight();
+        }
+        double variance{(static_cast<double>(sumSquares) / count - m * m) * count / (count - 1)};
+        return std::sqrt(std::max(0.0, variance) / count);
+    }
+
+    //probability of a track making at least the given number of hits
+    double tailProbability(int hits) const
+    {
+        double tail{0};
+        if(weighted())
+        {
+            for(std::size_t i{static_cast<std::size_t>(std::max(hits, 0))}; i < weights.size(); ++i) {tail += weights[i];}
+            return tail / totalWeight();
+        }
+        for(std::size_t i{static_cast<std::size_t>(std::max(hits, 0))}; i < histogram.size(); ++i) {tail += histogram[i];}
+        return count > 0 ? tail / count : 0;
+    }
+
+    //standard error of tailProbability
+    double tailError(int hits) const
+    {
+        if(count < 2) {return 0;}
+        double p{tailProbability(hits)};
+        if(weighted())
+        {
+            double spread{0};
+            for(std::size_t i{0}; i < weightsSquared.size(); ++i)
+            {
+                double indicator{static_cast<int>(i) >= hits ? 1.0 : 0.0};
+                spread += weightsSquared[i] * (indicator - p) * (indicator - p);
+            }
+            return std::sqrt(spread) / totalWeight();
+        }
+        return std::sqrt(p * (1 - p) / (count - 1));
+    }
+
+    //number of unweighted tracks that would give the same precision, equal to count for unweighted runs
+    double effectiveCount() const
+    {
+        if(!weighted()) {return static_cast<double>(count);}
+        double squares{0};
+        for(double square : weightsSquared) {squares += square;}
+        return squares > 0 ? totalWeight() * totalWeight() / squares : 0;
+    }
+};
+
+/*
+These functions write and read the statistics as plain text, one field per line, e.g.
+
+        count 1000000
+        sum 1756031
+        sumSquares 4410021
+        histogram 5 238212 301117 ...
+
+where the first number after histogram is the number of bins. Weighted runs add two more lines in the same form,
+weights and weightsSquared, with the weights at full precision. read returns false if the input is not in this form
+*/
+
+inline void writeStatistics(std::ostream& out, const RunStatistics& stats)
+{
+    out << "count " << stats.count << '\n';
+    out << "sum " << stats.sum << '\n';
+    out << "sumSquares " << stats.sumSquares << '\n';
+    out << "histogram " << stats.histogram.size();
+    for(long long bin : stats.histogram) {out << ' ' << bin;}
+    out << '\n';
+    if(stats.weighted())
+    {
+        std::streamsize precision{out.precision(17)};
+        out << "weights " << stats.weights.size();
+        for(double bin : stats.weights) {out << ' ' << bin;}
+        out << "\nweightsSquared " << stats.weightsSquared.size();
+        for(double bin : stats.weightsSquared) {out << ' ' << bin;}
+        out << '\n';
+        out.precision(precision);
+    }
+}
+
+inline bool readStatistics(std::istream& in, RunStatistics& stats)
+{
+    std::string name{};
+    std::size_t bins{0};
+    RunStatistics read{};
+    if(!(in >> name >> read.count) || name != "count") {return false;}
+    if(!(in >> name >> read.sum) || name != "sum") {return false;}
+    if(!(in >> name >> read.sumSquares) || name != "sumSquares") {return false;}
+    if(!(in >> name >> bins) || name != "histogram") {return false;}
+    read.histogram.resize(bins, 0);
+    for(long long& bin : read.histogram)
+    {
+        if(!(in >> bin)) {return false;}
+    }
+    //the weights are only there for weighted runs
+    if(in >> name)
+    {
+        if(name != "weights" || !(in >> bins)) {return false;}
+        read.weights.resize(bins, 0);
+        for(double& bin : read.weights)
+        {
+            if(!(in >> bin)) {return false;}
+        }
+        if(!(in >> name >> bins) || name != "weightsSquared") {return false;}
+        read.weightsSquared.resize(bins, 0);
+        for(double& bin : read.weightsSquared)
+        {
+            if(!(in >> bin)) {return false;}
+        }
+    }
+    stats = read;
+    return true;
+}
+
+#endif
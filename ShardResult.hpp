@@ -0,0 +1,60 @@
+#ifndef SHARD_RESULT_HPP
+#define SHARD_RESULT_HPP
+
+#include <fstream>
+#include <string>
+
+#include "RunStatistics.hpp"
+
+/*
+Partial results of a run that has been split into shards. A shard simulates the tracks first ... last - 1 of a run of
+total tracks, and as every track has its own generator (see TrackRandom.hpp) shards with different ranges never share
+random numbers. The file is the run key, the track range, the length of the run and the statistics as text:
+
+        key simulator=...;seed=1
+        first 0
+        last 250000
+        total 1000000
+        count 250000
+        ...
+
+MergeShards.cpp combines any set of these into the result of the whole run.
+*/
+
+struct ShardResult
+{
+    std::string key{};
+    long long first{0};
+    long long last{0};
+    long long total{0};     //tracks in the whole run, so a missing last shard can be found
+    RunStatistics stats{};
+};
+
+inline bool writeShardResult(const std::string& path, const ShardResult& shard)
+{
+    std::ofstream file(path);
+    file << "key " << shard.key << '\n';
+    file << "first " << shard.first << '\n';
+    file << "last " << shard.last << '\n';
+    file << "total " << shard.total << '\n';
+    writeStatistics(file, shard.stats);
+    return static_cast<bool>(file);
+}
+
+inline bool readShardResult(const std::string& path, ShardResult& shard)
+{
+    std::ifstream file(path);
+    std::string line{};
+    std::string name{};
+    ShardResult read{};
+    if(!std::getline(file, line) || line.rfind("key ", 0) != 0) {return false;}
+    read.key = line.substr(4);
+    if(!(file >> name >> read.first) || name != "first") {return false;}
+    if(!(file >> name >> read.last) || name != "last") {return false;}
+    if(!(file >> name >> read.total) || name != "total") {return false;}
+    if(!readStatistics(file, read.stats)) {return false;}
+    shard = read;
+    return true;
+}
+
+#endif
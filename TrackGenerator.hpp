@@ -0,0 +1,331 @@
+#ifndef TRACK_GENERATOR_HPP
+#define TRACK_GENERATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+Generation of the straight tracks for the standalone simulations. A track is the line through (x1, y1, z1) with
+direction (a, b, c), the y axis is vertical.
+
+There are three sources of tracks:
+
+        uniform:    the original generator, a start point anywhere in the middle 80% of the detector and direction
+                    components uniform in [-100, 100]. This is neither isotropic nor like cosmic rays, it is kept so
+                    that older results can still be reproduced
+        isotropic:  directions uniform over the sphere
+        cosmic:     the cos^2(theta) zenith angle distribution of cosmic ray muons at sea level
+
+The isotropic and cosmic tracks all cross the detector. Parallel tracks that hit a box cover its shadow, whose area is
+the sum over the three pairs of faces of (face area) * |d . n|, so a direction d is kept with probability proportional to
+its shadow (directions that see a large side of the detector are hit more often), then the face the track enters through
+is picked with probability proportional to that face's part of the shadow and the entry point is uniform on the face.
+This gives exactly the tracks of a uniform flux through the detector, without simulating the tracks that miss it.
+
+Zenith angles are drawn by inverting the cumulative distribution: with u = cos(theta) the flux per solid angle
+cos^n(theta) gives u = xi^(1 / (n + 1)) for xi uniform in [0, 1], n = 0 is isotropic and n = 2 is cosmic.
+
+Isotropic and cosmic tracks can also be importance sampled, see importanceTrack, then each track carries a weight.
+*/
+
+struct Track
+{
+    double x1, y1, z1;      //a point on the track
+    double a, b, c;         //direction of the track
+    double weight{1};       //statistical weight, 1 unless the track is importance sampled
+};
+
+//an axis aligned box, lower and upper corners as x, y, z
+struct Box
+{
+    std::array<double, 3> lower;
+    std::array<double, 3> upper;
+};
+
+enum class TrackSource {uniform, isotropic, cosmic};
+
+inline std::string trackSourceName(TrackSource source)
+{
+    switch(source)
+    {
+        case TrackSource::isotropic: return "isotropic";
+        case TrackSource::cosmic: return "cosmic";
+        default: return "uniform";
+    }
+}
+
+//returns false if the name is not one of the track sources
+inline bool parseTrackSource(const std::string& name, TrackSource& source)
+{
+    for(TrackSource candidate : {TrackSource::uniform, TrackSource::isotropic, TrackSource::cosmic})
+    {
+        if(name == trackSourceName(candidate))
+        {
+            source = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+This function makes a track of the original uniform generator, drawing the random numbers in the same order as before
+
+inputs:
+        start: Box, the region the start point is drawn from
+        gen: the random number generator of the current track
+
+outputs:
+        Track, the track
+*/
+
+template <typename Generator>
+Track uniformTrack(const Box& start, Generator& gen)
+{
+    Track track{};
+    track.x1 = std::uniform_real_distribution<double>(start.lower[0], start.upper[0])(gen);
+    track.y1 = std::uniform_real_distribution<double>(start.lower[1], start.upper[1])(gen);
+    track.z1 = std::uniform_real_distribution<double>(start.lower[2], start.upper[2])(gen);
+    track.a = std::uniform_real_distribution<double>(-100, 100)(gen);
+    track.b = std::uniform_real_distribution<double>(-100, 100)(gen);
+    track.c = std::uniform_real_distribution<double>(-100, 100)(gen);
+    return track;
+}
+
+/*
+This function draws a unit direction with a flux per solid angle of cos^power(theta) about the vertical y axis
+
+inputs:
+        power: double, 0 for isotropic, 2 for cosmic rays
+        gen: the random number generator of the current track
+
+outputs:
+        std::array<double, 3>, the direction
+*/
+
+template <typename Generator>
+std::array<double, 3> cosinePowerDirection(double power, Generator& gen)
+{
+    const double pi{3.14159265358979323846};
+    std::uniform_real_distribution<double> unif(0, 1);
+    double cosTheta{std::pow(unif(gen), 1 / (power + 1))};
+    double sinTheta{std::sqrt(std::max(0.0, 1 - cosTheta * cosTheta))};
+    double phi{2 * pi * unif(gen)};
+    return {sinTheta * std::cos(phi), cosTheta, sinTheta * std::sin(phi)};
+}
+
+//the areas of the box's faces facing along x, y and z
+inline std::array<double, 3> faceAreas(const Box& detector)
+{
+    std::array<double, 3> size{};
+    for(int i{0}; i < 3; ++i) {size[i] = detector.upper[i] - detector.lower[i];}
+    return {size[1] * size[2], size[0] * size[2], size[0] * size[1]};
+}
+
+/*
+This function picks the face a track with the given direction enters the detector through, with probability in
+proportion to that face's part of the shadow, and a uniform point on that face. The lower face of a pair is used if the
+track goes up that axis and the upper face if it goes down, so that every crossing track has exactly one entry face
+
+inputs:
+        detector: Box, a box around all of the sensors
+        direction: the direction of the track
+        gen: the random number generator of the current track
+
+outputs:
+        std::array<double, 3>, the entry point
+*/
+
+template <typename Generator>
+std::array<double, 3> entryPoint(const Box& detector, const std::array<double, 3>& direction, Generator& gen)
+{
+    std::uniform_real_distribution<double> unif(0, 1);
+    std::array<double, 3> faceArea{faceAreas(detector)};
+    std::array<double, 3> shadow{};
+    for(int i{0}; i < 3; ++i) {shadow[i] = faceArea[i] * std::abs(direction[i]);}
+
+    double pick{unif(gen) * (shadow[0] + shadow[1] + shadow[2])};
+    int face{pick < shadow[0] ? 0 : (pick < shadow[0] + shadow[1] ? 1 : 2)};
+    std::array<double, 3> point{};
+    for(int i{0}; i < 3; ++i)
+    {
+        if(i == face) {point[i] = direction[i] > 0 ? detector.lower[i] : detector.upper[i];}
+        else {point[i] = detector.lower[i] + unif(gen) * (detector.upper[i] - detector.lower[i]);}
+    }
+    return point;
+}
+
+/*
+This function makes a track with a flux per solid angle of cos^power(theta) that crosses the detector
+
+inputs:
+        detector: Box, a box around all of the sensors
+        power: double, 0 for isotropic, 2 for cosmic rays
+        gen: the random number generator of the current track
+
+outputs:
+        Track, the track
+*/
+
+template <typename Generator>
+Track crossingTrack(const Box& detector, double power, Generator& gen)
+{
+    std::uniform_real_distribution<double> unif(0, 1);
+    std::array<double, 3> faceArea{faceAreas(detector)};
+    //the shadow of the box is never larger than this
+    double largestShadow{std::sqrt(faceArea[0] * faceArea[0] + faceArea[1] * faceArea[1] + faceArea[2] * faceArea[2])};
+
+    std::array<double, 3> direction{};
+    std::array<double, 3> shadow{};
+    double totalShadow{0};
+    do
+    {
+        direction = cosinePowerDirection(power, gen);
+        for(int i{0}; i < 3; ++i) {shadow[i] = faceArea[i] * std::abs(direction[i]);}
+        totalShadow = shadow[0] + shadow[1] + shadow[2];
+    }
+    while(unif(gen) * largestShadow > totalShadow);
+
+    std::array<double, 3> point{entryPoint(detector, direction, gen)};
+    return {point[0], point[1], point[2], direction[0], direction[1], direction[2]};
+}
+
+/*
+Importance sampling. Tracks that make many hits are rare, they are the near vertical tracks that run down a column of
+stacked sensors, and they decide the tail of the hits distribution. The biased generator draws
+
+        directions from cos^n(theta) with the true power n for a share of the tracks and a larger power m for the rest
+        the track through a random point of a random sensor column (on a plane across the middle of the detector) for
+        a share of the tracks, and through the detector's shadow as in crossingTrack for the rest
+
+and gives each track the weight (true density) / (biased density), both as densities over directions and over the
+plane perpendicular to the track. The true density is cos^n / (mean shadow) for every track crossing the detector. As
+the biased density always includes the true directions and the whole shadow, the weights are never larger than
+(largest shadow) / (mean shadow * share of true directions * share of shadow tracks), so no track can swamp a run.
+*/
+
+struct ImportanceSettings
+{
+    double power{200};          //zenith power m of the biased directions, tracks with many hits are within a few degrees of vertical
+    double directionShare{0.2}; //share of the directions drawn from the true distribution
+    double columnShare{0.5};    //share of the tracks aimed at a sensor column
+};
+
+//the stacks of sensors the biased tracks are aimed at, as rectangles on a horizontal plane
+struct SensorColumns
+{
+    std::vector<std::array<double, 2>> centres{};   //x, z of the middle of each column
+    double halfWidth{0};                            //half size of the rectangles in x
+    double halfDepth{0};                            //half size of the rectangles in z
+    double height{0};                               //y of the plane
+};
+
+//flux per solid angle of cos^power(theta), normalised over the half sphere of directions (tracks are lines so up and
+//down are the same)
+inline double cosinePowerDensity(double power, double cosTheta)
+{
+    const double pi{3.14159265358979323846};
+    return (power + 1) / (2 * pi) * std::pow(std::abs(cosTheta), power);
+}
+
+//mean shadow of the detector over directions drawn from cos^power(theta), with u = cos(theta) the mean of |u| is
+//(n + 1) / (n + 2) and the mean of |sin(theta) cos(phi)| is (2 / pi) (n + 1) B((n + 1) / 2, 3 / 2) / 2
+inline double meanShadow(const Box& detector, double power)
+{
+    const double pi{3.14159265358979323846};
+    std::array<double, 3> faceArea{faceAreas(detector)};
+    double a{(power + 1) / 2};
+    double beta{std::tgamma(a) * std::tgamma(1.5) / std::tgamma(a + 1.5)};
+    double side{(2 / pi) * (power + 1) * beta / 2};
+    return faceArea[1] * (power + 1) / (power + 2) + (faceArea[0] + faceArea[2]) * side;
+}
+
+//density of the points aimed at sensor columns, per unit area of the columns' plane
+inline double columnDensity(const SensorColumns& columns, double x, double z)
+{
+    int inside{0};
+    for(const std::array<double, 2>& centre : columns.centres)
+    {
+        if(std::abs(x - centre[0]) <= columns.halfWidth && std::abs(z - centre[1]) <= columns.halfDepth) {++inside;}
+    }
+    return inside / (columns.centres.size() * 4 * columns.halfWidth * columns.halfDepth);
+}
+
+/*
+This function makes an importance sampled track for a flux per solid angle of cos^power(theta) through the detector
+
+inputs:
+        detector: Box, a box around all of the sensors, it must hold all of the columns
+        power: double, 0 for isotropic, 2 for cosmic rays
+        columns: SensorColumns, the sensor columns to aim at
+        settings: ImportanceSettings, how strongly to bias the tracks
+        gen: the random number generator of the current track
+
+outputs:
+        Track, the track and its weight
+*/
+
+template <typename Generator>
+Track importanceTrack(const Box& detector, double power, const SensorColumns& columns, const ImportanceSettings& settings,
+                      Generator& gen)
+{
+    std::uniform_real_distribution<double> unif(0, 1);
+    std::array<double, 3> direction{cosinePowerDirection(unif(gen) < settings.directionShare ? power : settings.power, gen)};
+
+    std::array<double, 3> point{};
+    if(unif(gen) < settings.columnShare)
+    {
+        const std::array<double, 2>& centre{columns.centres[static_cast<std::size_t>(unif(gen) * columns.centres.size())
+                                                            % columns.centres.size()]};
+        point[0] = centre[0] + (2 * unif(gen) - 1) * columns.halfWidth;
+        point[1] = columns.height;
+        point[2] = centre[1] + (2 * unif(gen) - 1) * columns.halfDepth;
+    }
+    else {point = entryPoint(detector, direction, gen);}
+
+    //the densities, per unit solid angle and per unit area across the track
+    std::array<double, 3> faceArea{faceAreas(detector)};
+    double shadow{faceArea[0] * std::abs(direction[0]) + faceArea[1] * std::abs(direction[1]) + faceArea[2] * std::abs(direction[2])};
+    double aimed{0};
+    if(direction[1] != 0)
+    {
+        double t{(columns.height - point[1]) / direction[1]};
+        aimed = columnDensity(columns, point[0] + direction[0] * t, point[2] + direction[2] * t) / std::abs(direction[1]);
+    }
+    double directionDensity{settings.directionShare * cosinePowerDensity(power, direction[1])
+                            + (1 - settings.directionShare) * cosinePowerDensity(settings.power, direction[1])};
+    double biased{directionDensity * ((1 - settings.columnShare) / shadow + settings.columnShare * aimed)};
+    double target{cosinePowerDensity(power, direction[1]) / meanShadow(detector, power)};
+
+    return {point[0], point[1], point[2], direction[0], direction[1], direction[2], target / biased};
+}
+
+/*
+This function makes a track from any of the sources
+
+inputs:
+        source: TrackSource, where the track comes from
+        start: Box, the region start points of uniform tracks are drawn from
+        detector: Box, a box around all of the sensors
+        gen: the random number generator of the current track
+
+outputs:
+        Track, the track
+*/
+
+template <typename Generator>
+Track generateTrack(TrackSource source, const Box& start, const Box& detector, Generator& gen)
+{
+    switch(source)
+    {
+        case TrackSource::isotropic: return crossingTrack(detector, 0, gen);
+        case TrackSource::cosmic: return crossingTrack(detector, 2, gen);
+        default: return uniformTrack(start, gen);
+    }
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TRACK_RANDOM_HPP
+#define TRACK_RANDOM_HPP
+
+#include <cstdint>
+#include <limits>
+
+/*
+Random numbers for the standalone simulations. Every track gets its own small generator whose starting state is a
+hash of the run seed and the track number, so the random numbers of a track do not depend on how many tracks came
+before it. A run can then be continued, split up or resumed from any track number and still give exactly the tracks an
+uninterrupted run would have given.
+*/
+
+//mixing function of splitmix64, it spreads nearby inputs over the whole 64 bit range
+inline std::uint64_t mix64(std::uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+//splitmix64 generator, small enough to make a fresh one for every track, usable with the std:: distributions
+struct SplitMix64
+{
+    using result_type = std::uint64_t;
+
+    std::uint64_t state;
+
+    static constexpr result_type min() {return 0;}
+    static constexpr result_type max() {return std::numeric_limits<result_type>::max();}
+
+    result_type operator()()
+    {
+        state += 0x9e3779b97f4a7c15ULL;
+        return mix64(state);
+    }
+};
+
+/*
+This function returns the generator for one track of a run
+
+inputs:
+        seed: the seed of the run
+        track: the number of the track within the run
+
+outputs:
+        SplitMix64, the generator for that track
+*/
+
+inline SplitMix64 trackEngine(std::uint64_t seed, std::uint64_t track)
+{
+    return SplitMix64{mix64(seed ^ mix64(track + 0x632be59bd9b4e019ULL))};
+}
+
+#endif